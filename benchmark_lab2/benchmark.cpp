@@ -4,13 +4,24 @@
 #include <cstdint>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
 
 #include "simulation/naive_sequential_simulation.h"
 
 
 #include "simulation/naive_parallel_simulation.h"
+#include "simulation/naive_simd_simulation.h"
+#include "structures/universe_soa.h"
 #include "simulation/barnes_hut_simulation.h"
 #include "simulation/barnes_hut_simulation_with_collisions.h"
+#include "simulation/fmm_simulation.h"
+#include "simulation/pm_simulation.h"
+#include "simulation/tree_pm_simulation.h"
+#include "simulation/integrator.h"
+#include "simulation/block_timestep_simulation.h"
+#include "simulation/hermite_simulation.h"
 
 #include "input_generator/input_generator.h"
 
@@ -86,6 +97,126 @@ static void benchmark_naive_parallel(benchmark::State& state) {
 	}	
 }
 
+// force pass of the parallel engine with range(1) threads
+static void benchmark_naive_parallel_threads(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const int number_threads = static_cast<int>(state.range(1));
+
+	Universe uni;
+	InputGenerator::create_random_universe(number_bodies, uni);
+
+	const int previous_threads = omp_get_max_threads();
+	omp_set_num_threads(number_threads);
+	for (auto _ : state) {
+		NaiveParallelSimulation::calculate_forces(uni);
+	}
+	omp_set_num_threads(previous_threads);
+	state.counters["threads"] = number_threads;
+}
+
+// force pass of the SIMD direct summation, range(1) selects the kernel
+// 0 -> separate velocity and position sweeps, 1 -> fused Integrator::step
+static void benchmark_integrator_step(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const bool fused = state.range(1) == 1;
+
+	Universe uni;
+	InputGenerator::create_random_universe(number_bodies, uni);
+	NaiveParallelSimulation::calculate_forces(uni);
+
+	for (auto _ : state) {
+		if (fused) {
+			Integrator::step(uni);
+		}
+		else {
+			NaiveParallelSimulation::calculate_velocities(uni);
+			NaiveParallelSimulation::calculate_positions(uni);
+		}
+	}
+}
+
+static void benchmark_naive_simd(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto kernel = static_cast<NaiveSimdSimulation::Kernel>(state.range(1));
+	if (!NaiveSimdSimulation::is_supported(kernel)) {
+		state.SkipWithError("kernel not supported by this CPU");
+		return;
+	}
+
+	Universe uni;
+	InputGenerator::create_random_universe(number_bodies, uni);
+	for (auto _ : state) {
+		NaiveSimdSimulation::calculate_forces(uni, kernel);
+	}
+}
+
+static void benchmark_hermite(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		HermiteSimulation::simulate_epochs(plotter, uni, number_epochs, false, 1);
+	}
+}
+
+static void benchmark_naive_parallel_soa(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe and convert it to the structure-of-arrays layout
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		UniverseSoA soa(uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		NaiveParallelSimulation::simulate_epochs(plotter, soa, number_epochs, false, 1);
+	}
+}
+
+// Force pass in the given precision. Reports the largest per-body relative
+// force error against the double precision path as a counter.
+template <typename Precision>
+static void benchmark_naive_parallel_soa_precision(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+
+	Universe uni;
+	InputGenerator::create_random_universe(number_bodies, uni);
+	UniverseSoA reference(uni);
+	NaiveParallelSimulation::calculate_forces(reference);
+	BasicUniverseSoA<Precision> soa(uni);
+
+	for (auto _ : state) {
+		NaiveParallelSimulation::calculate_forces(soa);
+		benchmark::ClobberMemory();
+	}
+
+	double max_error = 0.0;
+	for (std::uint32_t i = 0; i < soa.num_bodies; i++) {
+		double error_x = soa.force_x[i] - reference.force_x[i];
+		double error_y = soa.force_y[i] - reference.force_y[i];
+		double reference_norm2 = reference.force_x[i] * reference.force_x[i] + reference.force_y[i] * reference.force_y[i];
+		max_error = std::max(max_error, std::sqrt((error_x * error_x + error_y * error_y) / reference_norm2));
+	}
+	state.counters["max_rel_error"] = max_error;
+	state.counters["interactions"] = benchmark::Counter(static_cast<double>(number_bodies) * number_bodies, benchmark::Counter::kIsIterationInvariantRate);
+}
+
 
 static void benchmark_barnes_hut(benchmark::State& state) {
 	const auto number_bodies = state.range(0);
@@ -107,6 +238,221 @@ static void benchmark_barnes_hut(benchmark::State& state) {
 	}	
 }
 
+static void benchmark_barnes_hut_dual_tree(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		BarnesHutSimulation::simulate_epochs_dual_tree(plotter, uni, number_epochs, false, 1);
+	}
+}
+
+static void benchmark_barnes_hut_grouped(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		BarnesHutSimulation::simulate_epochs_grouped(plotter, uni, number_epochs, false, 1);
+	}
+}
+
+static void benchmark_fmm(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+	const std::int32_t order = state.range(2);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		FmmSimulation::simulate_epochs(plotter, uni, number_epochs, false, 1, order);
+	}
+}
+
+static void benchmark_pm(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+	const std::int32_t grid_size = state.range(2);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		PmSimulation::simulate_epochs(plotter, uni, number_epochs, false, 1, grid_size);
+	}
+}
+
+static void benchmark_tree_pm(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+	const std::int32_t grid_size = state.range(2);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		TreePmSimulation::simulate_epochs(plotter, uni, number_epochs, false, 1, grid_size);
+	}
+}
+
+// with black holes, max_rung 0 moves every body with the epoch
+static void benchmark_block_timesteps(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+	const std::int32_t max_rung = state.range(2);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe_with_supermassive_blackholes(number_bodies, uni, 2);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		BlockTimestepSimulation::simulate_epochs(plotter, uni, number_epochs, false, 1, max_rung);
+	}
+}
+
+static void benchmark_barnes_hut_incremental(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		BarnesHutSimulation::simulate_epochs_incremental(plotter, uni, number_epochs, false, 1);
+	}
+}
+
+static void benchmark_barnes_hut_linear(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const auto number_epochs = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		// create dummy plotter
+		BoundingBox bb(-5, 5, -5, 5);
+		auto tmp_path = std::filesystem::path{"dummy_plot"};
+		Plotter plotter(bb, tmp_path, 400, 400);
+
+		state.ResumeTiming();
+		BarnesHutSimulation::simulate_epochs_linear(plotter, uni, number_epochs, false, 1);
+	}
+}
+
+static void benchmark_construct_linear_quadtree(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+		BoundingBox bb = uni.get_bounding_box();
+
+		state.ResumeTiming();
+		LinearQuadtree qt(uni, bb);
+		qt.calculate_center_of_mass();
+	}
+}
+
+static void benchmark_barnes_hut_leaf_capacity(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const std::int32_t leaf_capacity = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// initialize universe
+		Universe uni;
+		InputGenerator::create_random_universe(number_bodies, uni);
+
+		state.ResumeTiming();
+		Quadtree qt(uni, uni.get_bounding_box(), 2, leaf_capacity);
+		BarnesHutSimulation::calculate_forces(uni, qt);
+	}
+}
+
+// force pass for theta = range(1) / 10 with or without quadrupole moments,
+// reports the relative error against the naive forces next to the time
+static void benchmark_barnes_hut_multipole(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const double threshold_theta = state.range(1) / 10.0;
+	const bool use_quadrupole = state.range(2) != 0;
+
+	Universe uni;
+	InputGenerator::create_random_universe(number_bodies, uni);
+	Universe reference = uni;
+	NaiveParallelSimulation::calculate_forces(reference);
+	Quadtree qt(uni, uni.get_bounding_box(), 2);
+
+	for (auto _ : state) {
+		BarnesHutSimulation::calculate_forces(uni, qt, threshold_theta, use_quadrupole);
+	}
+
+	double error = 0.0;
+	double norm = 0.0;
+	for (std::uint32_t i = 0; i < uni.num_bodies; i++) {
+		error += std::sqrt((uni.forces[i] - reference.forces[i]).norm2());
+		norm += std::sqrt(reference.forces[i].norm2());
+	}
+	state.counters["rel_error"] = error / norm;
+}
+
 static void benchmark_barnes_hut_with_collisions(benchmark::State& state) {
 	const auto number_bodies = state.range(0);
 
@@ -142,6 +488,22 @@ static void benchmark_construct_quadtree(benchmark::State& state) {
 	}	
 }
 
+static void benchmark_construct_quadtree_black_holes(benchmark::State& state) {
+	const auto number_bodies = state.range(0);
+	const std::int8_t construct_mode = state.range(1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// clustered universe, the subtrees differ strongly in size
+		Universe uni;
+		InputGenerator::create_random_universe_with_supermassive_blackholes(number_bodies, uni, 4);
+		BoundingBox bb = uni.get_bounding_box();
+
+		state.ResumeTiming();
+		Quadtree(uni, bb, construct_mode);
+	}
+}
+
 static void benchmark_calculate_cumulative_masses(benchmark::State& state) {
 	const auto number_bodies = state.range(0);
 
@@ -205,6 +567,48 @@ BENCHMARK(benchmark_get_bounding_box_sequential)->Unit(benchmark::kMillisecond)-
 BENCHMARK(benchmark_get_bounding_box_parallel)->Unit(benchmark::kMillisecond)->Args({100000});
 BENCHMARK(benchmark_get_bounding_box_parallel)->Unit(benchmark::kMillisecond)->Args({10000000});
 BENCHMARK(benchmark_get_bounding_box_parallel)->Unit(benchmark::kMillisecond)->Args({100000000});
+
+BENCHMARK(benchmark_naive_parallel_soa)->Unit(benchmark::kMillisecond)->Args({1000, 1});
+BENCHMARK(benchmark_naive_parallel_soa)->Unit(benchmark::kMillisecond)->Args({10000, 1});
+
+BENCHMARK(benchmark_naive_parallel_threads)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {1, 2, 4, 8, 16}});
+BENCHMARK(benchmark_naive_simd)->Unit(benchmark::kMillisecond)->ArgsProduct({{10000, 50000}, {0, 1, 2}});
+BENCHMARK(benchmark_hermite)->Unit(benchmark::kMillisecond)->ArgsProduct({{100, 1000}, {10}});
+BENCHMARK(benchmark_integrator_step)->Unit(benchmark::kMillisecond)->ArgsProduct({{10000000}, {0, 1}});
+
+BENCHMARK_TEMPLATE(benchmark_naive_parallel_soa_precision, DoublePrecision)->Unit(benchmark::kMillisecond)->Args({10000});
+BENCHMARK_TEMPLATE(benchmark_naive_parallel_soa_precision, FloatComputePrecision)->Unit(benchmark::kMillisecond)->Args({10000});
+BENCHMARK_TEMPLATE(benchmark_naive_parallel_soa_precision, FloatPrecision)->Unit(benchmark::kMillisecond)->Args({10000});
+
+BENCHMARK(benchmark_construct_quadtree)->Unit(benchmark::kMillisecond)->Args({1000000, 2});
+BENCHMARK(benchmark_construct_quadtree)->Unit(benchmark::kMillisecond)->Args({1000000, 3});
+BENCHMARK(benchmark_construct_quadtree_black_holes)->Unit(benchmark::kMillisecond)->Args({1000000, 1});
+BENCHMARK(benchmark_construct_quadtree_black_holes)->Unit(benchmark::kMillisecond)->Args({1000000, 2});
+
+BENCHMARK(benchmark_construct_linear_quadtree)->Unit(benchmark::kMillisecond)->Args({200000});
+BENCHMARK(benchmark_construct_linear_quadtree)->Unit(benchmark::kMillisecond)->Args({1000000});
+
+BENCHMARK(benchmark_barnes_hut_linear)->Unit(benchmark::kMillisecond)->Args({10000, 1});
+BENCHMARK(benchmark_barnes_hut_linear)->Unit(benchmark::kMillisecond)->Args({100000, 1});
+
+BENCHMARK(benchmark_barnes_hut)->Unit(benchmark::kMillisecond)->Args({20000, 10});
+BENCHMARK(benchmark_barnes_hut_incremental)->Unit(benchmark::kMillisecond)->Args({20000, 10});
+BENCHMARK(benchmark_barnes_hut_dual_tree)->Unit(benchmark::kMillisecond)->Args({20000, 10});
+BENCHMARK(benchmark_barnes_hut_grouped)->Unit(benchmark::kMillisecond)->Args({20000, 10});
+BENCHMARK(benchmark_block_timesteps)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {10}, {0, 4, 8}});
+BENCHMARK(benchmark_fmm)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {10}, {4, 6, 8}});
+BENCHMARK(benchmark_pm)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {10}, {256, 1024}});
+BENCHMARK(benchmark_tree_pm)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {10}, {256, 1024}});
+BENCHMARK(benchmark_barnes_hut)->Unit(benchmark::kMillisecond)->Args({1000000, 1});
+BENCHMARK(benchmark_pm)->Unit(benchmark::kMillisecond)->Args({1000000, 1, 1024});
+BENCHMARK(benchmark_tree_pm)->Unit(benchmark::kMillisecond)->Args({1000000, 1, 1024});
+
+BENCHMARK(benchmark_barnes_hut_leaf_capacity)->Unit(benchmark::kMillisecond)->Args({100000, 1});
+BENCHMARK(benchmark_barnes_hut_leaf_capacity)->Unit(benchmark::kMillisecond)->Args({100000, 8});
+BENCHMARK(benchmark_barnes_hut_leaf_capacity)->Unit(benchmark::kMillisecond)->Args({100000, 16});
+BENCHMARK(benchmark_barnes_hut_leaf_capacity)->Unit(benchmark::kMillisecond)->Args({100000, 64});
+
+BENCHMARK(benchmark_barnes_hut_multipole)->Unit(benchmark::kMillisecond)->ArgsProduct({{20000}, {2, 3, 4, 5, 7, 10}, {0, 1}});
 /*
 BENCHMARK(benchmark_construct_quadtree)->Unit(benchmark::kMillisecond)->Args({10000, 0});
 BENCHMARK(benchmark_construct_quadtree)->Unit(benchmark::kMillisecond)->Args({20000, 0});
@@ -9,14 +9,61 @@
 #include "structures/universe.h"
 #include "simulation/naive_sequential_simulation.h"
 #include "simulation/naive_parallel_simulation.h"
+#include "simulation/naive_simd_simulation.h"
 #include "simulation/barnes_hut_simulation.h"
 #include "simulation/barnes_hut_simulation_with_collisions.h"
+#include "simulation/fmm_simulation.h"
+#include "simulation/pm_simulation.h"
+#include "simulation/tree_pm_simulation.h"
+#include "simulation/block_timestep_simulation.h"
+#include "simulation/hermite_simulation.h"
+#include "physics/gravitation.h"
+#include "simulation/constants.h"
+#include "simulation/integrator.h"
 #include "utilities/export.hpp"
 #include "utilities/import.hpp"
 #include "input_generator/input_generator.h"
 #include "plotting/plotter.h"
 #include <exception>
 
+// Forces at the current positions with the engine of the simulation mode, for
+// the closing half kick of a leapfrog run. Modes 8 and 9 bring their own
+// integrators and never leave staggered velocities behind.
+static void calculate_final_forces(Universe& universe, std::uint32_t simulation_mode, std::int32_t fmm_order, std::int32_t pm_grid_size){
+	switch(simulation_mode){
+		case 0:
+			NaiveSequentialSimulation::calculate_forces(universe);
+			break;
+		case 1:
+			NaiveParallelSimulation::calculate_forces(universe);
+			break;
+		case 2:
+		case 3: {
+			Quadtree quadtree(universe, universe.get_bounding_box(), 2);
+			BarnesHutSimulation::calculate_forces(universe, quadtree);
+			break;
+		}
+		case 4: {
+			Quadtree quadtree(universe, universe.get_bounding_box(), 2, FmmSimulation::default_leaf_capacity);
+			FmmSimulation::calculate_forces(universe, quadtree, fmm_order);
+			break;
+		}
+		case 5:
+			NaiveSimdSimulation::calculate_forces(universe);
+			break;
+		case 6:
+			PmSimulation::calculate_forces(universe, pm_grid_size);
+			break;
+		case 7: {
+			Quadtree quadtree(universe, universe.get_bounding_box(), 2, TreePmSimulation::default_leaf_capacity);
+			TreePmSimulation::calculate_forces(universe, quadtree, pm_grid_size);
+			break;
+		}
+		default:
+			throw std::invalid_argument("simulation mode " + std::to_string(simulation_mode) + " has no leapfrog integration");
+	}
+}
+
 int main(int argc, char** argv) {
 	auto lab_cli_app = CLI::App{ "" };
 
@@ -26,6 +73,7 @@ int main(int argc, char** argv) {
 	//auto output_path = std::filesystem::path{"INVALID"};
 	auto output_path = std::string{"/work/scratch/kurse/kurs00084/kp51howe"};
 	auto save_universe_path = std::filesystem::path{"./universe.txt"};
+	auto save_final_universe_path = std::filesystem::path{};
 	auto load_universe_path = std::filesystem::path{"./NOTHING_TO_LOAD"};
 	bool output_intermediate_states = bool{true};
 	bool save_initial_universe = bool{true};
@@ -34,6 +82,12 @@ int main(int argc, char** argv) {
 	auto plot_bounding_box_scale = std::uint32_t{5};
 	auto universe_generator = std::uint32_t{ 0 };
 	auto simulation_mode = std::uint32_t{0};
+	auto fmm_order = std::int32_t{ FmmSimulation::default_order };
+	auto plummer_softening_length = double{ 0.0 };
+	auto integrator = std::uint32_t{ 0 };
+	auto epoch_length = double{ epoch_in_seconds };
+	auto pm_grid_size = std::int32_t{ PmSimulation::default_grid_size };
+	auto max_rung = std::int32_t{ BlockTimestepSimulation::default_max_rung };
 
 	lab_cli_app.add_option("--output-image-width", output_image_width, "default: 800px");
 	lab_cli_app.add_option("--output-image-height", output_image_height, "default: 800px");
@@ -45,8 +99,15 @@ int main(int argc, char** argv) {
 	lab_cli_app.add_option("--plot-bounding-box-scale", plot_bounding_box_scale, "Scale of the plotted bounding box compared to the initial bounding box of the system. Default: 5");
 	lab_cli_app.add_option("--universe-generator", universe_generator, "Select universe generator. Options: 0 -> Random universe. 1 -> Earth Orbit. 2 -> Random universe with at least one supermassive black hole. 3 -> Random universe with at least two supermassive black holes. Please feel free to add new generators. 4 -> Create two colliding bodies. Default: 0");
 	auto load_universe_option = lab_cli_app.add_option("--load-universe-path", load_universe_path, "Path to the universe file to be loaded.");
-	lab_cli_app.add_option("--simulation-mode", simulation_mode, "Select simulation mode. Options: 0 -> Naive sequential. 1 -> Naive parallel. 2 -> Barnes-Hut. 3 -> Barnes-Hut with collisions. Default: 0");
+	lab_cli_app.add_option("--simulation-mode", simulation_mode, "Select simulation mode. Options: 0 -> Naive sequential. 1 -> Naive parallel. 2 -> Barnes-Hut. 3 -> Barnes-Hut with collisions. 4 -> Fast multipole method. 5 -> Naive SIMD (AVX2/AVX-512 picked at runtime). 6 -> Particle mesh. 7 -> TreePM. 8 -> Barnes-Hut with block timesteps. 9 -> Hermite with individual timesteps, for small systems. Default: 0");
+	lab_cli_app.add_option("--fmm-order", fmm_order, "Order of the multipole expansions of --simulation-mode 4. Default: 6");
+	lab_cli_app.add_option("--pm-grid-size", pm_grid_size, "Cells per side of the mesh of --simulation-mode 6 and 7, a power of two. Default: 256");
+	lab_cli_app.add_option("--max-rung", max_rung, "Deepest timestep rung of --simulation-mode 8, the shortest step is the epoch / 2^max-rung. Default: 8");
+	lab_cli_app.add_option("--softening-length", plummer_softening_length, "Plummer softening length in m, applied by every simulation mode. Default: 0");
+	lab_cli_app.add_option("--integrator", integrator, "Select the time integrator of --simulation-mode 0 to 7, modes 8 and 9 bring their own and only accept 0. Options: 0 -> Symplectic Euler. 1 -> Kick-drift-kick leapfrog, allows several times longer epochs at the same energy error. Default: 0");
+	lab_cli_app.add_option("--epoch-in-seconds", epoch_length, "Simulated time of one epoch in s. Default: 2.628e6 (one month)");
 	lab_cli_app.add_option("--save-initial-universe", save_initial_universe, "Toggle saving the initial universe to --save-universe-path. Default: true");
+	lab_cli_app.add_option("--save-final-universe-path", save_final_universe_path, "Path to store the universe after the last epoch, leapfrog velocities are synchronized with the positions first. Default: not stored");
 
 	auto output_option = lab_cli_app.add_option("--output", output_path, "Required argument. Set the path to the output directory. MUST contain 'scratch'.");
 
@@ -65,6 +126,24 @@ int main(int argc, char** argv) {
 		throw std::invalid_argument("The output path must contain 'scratch'. When using the Lichtenberg cluster, position your output folder under /work/scratch/kurse/kurs00084/<TU-ID>");
 	}
 	output_option->check(CLI::ExistingDirectory);
+	if(plummer_softening_length < 0.0){
+		throw std::invalid_argument("The softening length must not be negative.");
+	}
+	softening_length = plummer_softening_length;
+	if(integrator > 1){
+		throw std::invalid_argument("unknown integrator: " + std::to_string(integrator));
+	}
+	if(integrator != 0 && simulation_mode > 7){
+		throw std::invalid_argument("--integrator only applies to --simulation-mode 0 to 7, modes 8 and 9 bring their own integrators.");
+	}
+	integration_scheme = integrator == 1 ? IntegrationScheme::leapfrog : IntegrationScheme::symplectic_euler;
+	if(!(epoch_length > 0.0)){
+		throw std::invalid_argument("The epoch length must be positive.");
+	}
+	epoch_in_seconds = epoch_length;
+	if(max_rung < 0 || max_rung > 30){
+		throw std::invalid_argument("The deepest rung must be between 0 and 30.");
+	}
 
 
 	// check if a universe shall be loaded or created
@@ -137,13 +216,42 @@ int main(int argc, char** argv) {
 		case 3:
 			BarnesHutSimulationWithCollisions::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs);
 			break;
+		case 4:
+			FmmSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs, fmm_order);
+			break;
+		case 5:
+			NaiveSimdSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs);
+			break;
+		case 6:
+			PmSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs, pm_grid_size);
+			break;
+		case 7:
+			TreePmSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs, pm_grid_size);
+			break;
+		case 8:
+			BlockTimestepSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs, max_rung);
+			break;
+		case 9:
+			HermiteSimulation::simulate_epochs(plotter, universe, number_epochs, output_intermediate_states, plot_intermediate_epochs);
+			break;
 		default:
 			throw std::invalid_argument("unknown simulation mode: " + std::to_string(simulation_mode));
 	}
 
+	// the leapfrog velocities lead the positions by half an epoch, the closing
+	// half kick brings them back before anything is exported
+	if(universe.velocities_staggered){
+		calculate_final_forces(universe, simulation_mode, fmm_order, pm_grid_size);
+		Integrator::synchronize_velocities(universe);
+	}
+
 	// plot simulation result
 	plotter.add_bodies_to_image(universe);
 	plotter.write_and_clear();
 
+	if(!save_final_universe_path.empty()){
+		save_universe(save_final_universe_path, universe);
+	}
+
 	return 0;
 }
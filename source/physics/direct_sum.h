@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "physics/gravitation.h"
+#include "structures/universe.h"
+#include "structures/vector2d.h"
+
+// Exact softened force on body i from the given bodies, summed directly. The
+// loop runs over positions and weights only and vectorizes; i itself (or any
+// body at distance 0) does not contribute. Shared by the Barnes-Hut leaves and
+// the FMM near field.
+[[nodiscard]] inline Vector2d<double> direct_force(Universe& universe, std::int32_t i, std::span<const std::int32_t> bodies){
+    const Vector2d<double> position = universe.positions[i];
+    const std::int32_t* indices = bodies.data();
+    const std::int32_t count = static_cast<std::int32_t>(bodies.size());
+    const double softening_squared = softening_length * softening_length;
+
+    double force_x = 0.0;
+    double force_y = 0.0;
+#pragma omp simd reduction(+:force_x, force_y)
+    for (std::int32_t k = 0; k < count; ++k) {
+        const std::int32_t j = indices[k];
+        const double dx = universe.positions[j].x - position.x;
+        const double dy = universe.positions[j].y - position.y;
+        const double factor = universe.weights[j] * softened_inverse_cube(dx * dx + dy * dy, softening_squared);
+        force_x += dx * factor;
+        force_y += dy * factor;
+    }
+
+    return Vector2d<double>(force_x, force_y) * (gravitational_constant * universe.weights[i]);
+}
@@ -4,7 +4,29 @@
 
 static const double gravitational_constant = 6.67430*1e-11; // (m^3)/(kg*s^2)
 
-[[nodiscard]] static double gravitational_force(double mass_1,  double mass_2, double distance){
-    return gravitational_constant * ((mass_1 * mass_2)/(pow(distance, 2)));
-}   
+// Plummer softening length in m, set once before a simulation starts. Every
+// engine evaluates F = G * m_1 * m_2 * r / (r^2 + eps^2)^(3/2), so close
+// encounters stay bounded and bodies at the same position exert no force on
+// each other. 0 gives the plain Newtonian force.
+inline double softening_length = 0.0;
 
+// 1 / (r^2 + eps^2)^(3/2), or 0 if both vanish. Written as selects so that it
+// vectorizes when inlined into a simd loop.
+[[nodiscard]] inline double softened_inverse_cube(double distance_squared, double softening_squared){
+    const double softened = distance_squared + softening_squared;
+    const double safe = softened > 0.0 ? softened : 1.0;
+    return softened > 0.0 ? 1.0 / (safe * std::sqrt(safe)) : 0.0;
+}
+
+// magnitude of the softened force, to be applied along the unit direction.
+// Without softening it is exactly the Newtonian G * m_1 * m_2 / r^2, and 0
+// for bodies at the same position.
+[[nodiscard]] inline double gravitational_force(double mass_1,  double mass_2, double distance){
+    if (softening_length > 0.0) {
+        return gravitational_constant * mass_1 * mass_2 * distance * softened_inverse_cube(distance * distance, softening_length * softening_length);
+    }
+    if (distance == 0.0) {
+        return 0.0;
+    }
+    return gravitational_constant * ((mass_1 * mass_2) / (distance * distance));
+}
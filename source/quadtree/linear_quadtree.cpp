@@ -0,0 +1,149 @@
+#include "quadtree/linear_quadtree.h"
+
+#include <algorithm>
+#include <omp.h>
+
+LinearQuadtree::LinearQuadtree(Universe& universe, BoundingBox bounding_box){
+    construct(universe, bounding_box);
+}
+
+// node for a square cell, size_squared is the squared diagonal (2 * half_width)^2 * 2
+static LinearQuadtreeNode make_node(Vector2d<double> center, double half_width){
+    LinearQuadtreeNode node;
+    node.center = center;
+    node.half_width = half_width;
+    node.size_squared = 8.0 * half_width * half_width;
+    return node;
+}
+
+void LinearQuadtree::construct(Universe& universe, BoundingBox bounding_box){
+    nodes.clear();
+    level_offsets.clear();
+    body_indices.clear();
+
+    // collect all bodies within the bounding box
+    for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
+        const Vector2d<double>& position = universe.positions[i];
+        if (position.x >= bounding_box.x_min && position.x <= bounding_box.x_max &&
+            position.y >= bounding_box.y_min && position.y <= bounding_box.y_max) {
+            body_indices.push_back(i);
+        }
+    }
+
+    // range of body_indices covered by each node, only needed during construction
+    std::vector<std::int32_t> range_begin;
+    std::vector<std::int32_t> range_end;
+
+    // square root cell around the bounding box
+    Vector2d<double> root_center((bounding_box.x_min + bounding_box.x_max) / 2.0, (bounding_box.y_min + bounding_box.y_max) / 2.0);
+    double root_half_width = std::max(bounding_box.x_max - bounding_box.x_min, bounding_box.y_max - bounding_box.y_min) / 2.0;
+    nodes.push_back(make_node(root_center, root_half_width));
+    range_begin.push_back(0);
+    range_end.push_back(static_cast<std::int32_t>(body_indices.size()));
+    level_offsets.push_back(0);
+
+    // breadth-first: every processed node appends its four children at the end
+    // of the array, so the children of a node are contiguous
+    std::int32_t level_end = 1;
+    std::int32_t depth = 0;
+    for (std::int32_t node_index = 0; node_index < static_cast<std::int32_t>(nodes.size()); ++node_index) {
+        if (node_index == level_end) {
+            level_offsets.push_back(node_index);
+            level_end = static_cast<std::int32_t>(nodes.size());
+            depth++;
+        }
+
+        std::int32_t begin = range_begin[node_index];
+        std::int32_t end = range_end[node_index];
+        if (end - begin <= 1 || depth >= max_depth) {
+            if (end > begin) {
+                nodes[node_index].body_identifier = body_indices[begin];
+            }
+            continue;
+        }
+
+        Vector2d<double> center = nodes[node_index].center;
+        double quarter_width = nodes[node_index].half_width / 2.0;
+
+        // partition the range in place into bottom-left, bottom-right, top-left, top-right
+        auto first = body_indices.begin() + begin;
+        auto last = body_indices.begin() + end;
+        auto top = std::partition(first, last, [&](std::int32_t idx) { return universe.positions[idx].y < center.y; });
+        auto bottom_right = std::partition(first, top, [&](std::int32_t idx) { return universe.positions[idx].x < center.x; });
+        auto top_right = std::partition(top, last, [&](std::int32_t idx) { return universe.positions[idx].x < center.x; });
+
+        std::int32_t bounds[5] = {
+            begin,
+            static_cast<std::int32_t>(bottom_right - body_indices.begin()),
+            static_cast<std::int32_t>(top - body_indices.begin()),
+            static_cast<std::int32_t>(top_right - body_indices.begin()),
+            end
+        };
+
+        nodes[node_index].first_child = static_cast<std::int32_t>(nodes.size());
+        for (int i = 0; i < 4; ++i) {
+            Vector2d<double> offset((i & 1) ? quarter_width : -quarter_width, (i & 2) ? quarter_width : -quarter_width);
+            nodes.push_back(make_node(center + offset, quarter_width));
+            range_begin.push_back(bounds[i]);
+            range_end.push_back(bounds[i + 1]);
+        }
+    }
+    level_offsets.push_back(static_cast<std::int32_t>(nodes.size()));
+
+    // leaves carry their bodies' mass and position right away, just like Quadtree
+#pragma omp parallel for
+    for (std::int32_t node_index = 0; node_index < static_cast<std::int32_t>(nodes.size()); ++node_index) {
+        LinearQuadtreeNode& node = nodes[node_index];
+        if (!node.is_leaf()) {
+            continue;
+        }
+        double mass = 0.0;
+        Vector2d<double> weighted_position(0.0, 0.0);
+        for (std::int32_t i = range_begin[node_index]; i < range_end[node_index]; ++i) {
+            double body_mass = universe.weights[body_indices[i]];
+            mass += body_mass;
+            weighted_position += universe.positions[body_indices[i]] * body_mass;
+        }
+        node.cumulative_mass = mass;
+        node.center_of_mass = mass > 0 ? weighted_position / mass : weighted_position;
+    }
+}
+
+void LinearQuadtree::calculate_cumulative_masses(){
+    // deepest level first; the nodes of one level are independent of each other
+    for (std::int32_t level = static_cast<std::int32_t>(level_offsets.size()) - 2; level >= 0; --level) {
+#pragma omp parallel for
+        for (std::int32_t node_index = level_offsets[level]; node_index < level_offsets[level + 1]; ++node_index) {
+            LinearQuadtreeNode& node = nodes[node_index];
+            if (node.is_leaf()) {
+                continue;
+            }
+            double mass = 0.0;
+            for (std::int32_t child = node.first_child; child < node.first_child + LinearQuadtreeNode::child_count; ++child) {
+                mass += nodes[child].cumulative_mass;
+            }
+            node.cumulative_mass = mass;
+        }
+    }
+}
+
+void LinearQuadtree::calculate_center_of_mass(){
+    // relies on the cumulative masses of the children, same as QuadtreeNode
+    calculate_cumulative_masses();
+
+    for (std::int32_t level = static_cast<std::int32_t>(level_offsets.size()) - 2; level >= 0; --level) {
+#pragma omp parallel for
+        for (std::int32_t node_index = level_offsets[level]; node_index < level_offsets[level + 1]; ++node_index) {
+            LinearQuadtreeNode& node = nodes[node_index];
+            if (node.is_leaf()) {
+                continue;
+            }
+            Vector2d<double> weighted_position(0.0, 0.0);
+            for (std::int32_t child = node.first_child; child < node.first_child + LinearQuadtreeNode::child_count; ++child) {
+                weighted_position += nodes[child].center_of_mass * nodes[child].cumulative_mass;
+            }
+            double total_mass = node.cumulative_mass;
+            node.center_of_mass = total_mass > 0 ? weighted_position / total_mass : Vector2d<double>(0.0, 0.0);
+        }
+    }
+}
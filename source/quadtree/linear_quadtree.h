@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "structures/vector2d.h"
+#include "structures/bounding_box.h"
+#include "structures/universe.h"
+
+// Node of a LinearQuadtree, exactly one cache line. Cells are squares given by
+// center and half width. Every internal node owns four consecutive child slots
+// starting at first_child, in the order bottom-left, bottom-right, top-left,
+// top-right; the slots of empty quadrants hold empty leaves. Mass and center of
+// mass come first, together with the squared cell diagonal they are all the
+// traversal reads for a node that is accepted.
+struct alignas(64) LinearQuadtreeNode{
+    Vector2d<double> center_of_mass;
+    double cumulative_mass = 0.0;
+    // squared diagonal of the cell, compared against theta^2 * r^2
+    double size_squared = 0.0;
+
+    Vector2d<double> center;
+    double half_width = 0.0;
+
+    std::int32_t first_child = -1;
+    std::int32_t body_identifier = -1;
+
+    static constexpr std::int32_t child_count = 4;
+
+    [[nodiscard]] bool is_leaf() const {
+        return first_child < 0;
+    }
+
+    [[nodiscard]] bool is_empty() const {
+        return is_leaf() && body_identifier == -1;
+    }
+
+    [[nodiscard]] BoundingBox get_bounding_box() const {
+        return BoundingBox(center.x - half_width, center.x + half_width, center.y - half_width, center.y + half_width);
+    }
+};
+
+static_assert(sizeof(LinearQuadtreeNode) == 64, "LinearQuadtreeNode must fill exactly one cache line");
+
+// Pointerless quadtree stored in flat arrays. Nodes are emitted level by level,
+// so the children of a node are contiguous and always have a larger index than
+// their parent. The upward passes therefore are plain reverse sweeps over the
+// arrays, and the whole tree is released by clearing a handful of vectors.
+// The root cell is the square around bounding_box.
+class LinearQuadtree{
+public:
+    LinearQuadtree(Universe& universe, BoundingBox bounding_box);
+
+    void construct(Universe& universe, BoundingBox bounding_box);
+
+    void calculate_cumulative_masses();
+    void calculate_center_of_mass();
+
+    static constexpr std::int32_t root = 0;
+    // bodies sharing a position can not be separated by subdivision, stop at this depth
+    static constexpr std::int32_t max_depth = 64;
+
+    std::vector<LinearQuadtreeNode> nodes;
+
+    // nodes of depth d are stored in [level_offsets[d], level_offsets[d+1])
+    std::vector<std::int32_t> level_offsets;
+
+private:
+    std::vector<std::int32_t> body_indices;
+};
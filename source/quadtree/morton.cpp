@@ -0,0 +1,103 @@
+#include "quadtree/morton.h"
+
+#include <algorithm>
+#include <omp.h>
+
+// spread the lower 32 bits of value to the even bit positions
+static std::uint64_t spread_bits(std::uint64_t value){
+    value &= 0x00000000ffffffffull;
+    value = (value | (value << 16)) & 0x0000ffff0000ffffull;
+    value = (value | (value << 8)) & 0x00ff00ff00ff00ffull;
+    value = (value | (value << 4)) & 0x0f0f0f0f0f0f0f0full;
+    value = (value | (value << 2)) & 0x3333333333333333ull;
+    value = (value | (value << 1)) & 0x5555555555555555ull;
+    return value;
+}
+
+static std::uint64_t quantize(double value, double minimum, double extent){
+    if (extent <= 0.0) {
+        return 0;
+    }
+    double scaled = (value - minimum) / extent * 4294967296.0;  // 2^32
+    if (scaled <= 0.0) {
+        return 0;
+    }
+    if (scaled >= 4294967295.0) {
+        return 0xffffffffull;
+    }
+    return static_cast<std::uint64_t>(scaled);
+}
+
+std::uint64_t Morton::encode(double x, double y, const BoundingBox& bounding_box){
+    std::uint64_t quantized_x = quantize(x, bounding_box.x_min, bounding_box.x_max - bounding_box.x_min);
+    std::uint64_t quantized_y = quantize(y, bounding_box.y_min, bounding_box.y_max - bounding_box.y_min);
+    return spread_bits(quantized_x) | (spread_bits(quantized_y) << 1);
+}
+
+void Morton::parallel_radix_sort(std::vector<std::uint64_t>& keys, std::vector<std::int32_t>& values){
+    const std::int64_t count = static_cast<std::int64_t>(keys.size());
+    if (count < 2) {
+        return;
+    }
+
+    // find the bytes that actually differ between keys
+    std::uint64_t varying_bits = 0;
+#pragma omp parallel for reduction(|: varying_bits)
+    for (std::int64_t i = 0; i < count; ++i) {
+        varying_bits |= keys[i] ^ keys[0];
+    }
+
+    std::vector<std::uint64_t> keys_buffer(count);
+    std::vector<std::int32_t> values_buffer(count);
+    const std::int32_t max_threads = omp_get_max_threads();
+    // histograms[thread * 256 + digit]
+    std::vector<std::int64_t> histograms(static_cast<std::size_t>(max_threads) * 256);
+
+    for (std::int32_t shift = 0; shift < 64; shift += 8) {
+        if (((varying_bits >> shift) & 0xffu) == 0) {
+            continue;
+        }
+
+        std::fill(histograms.begin(), histograms.end(), 0);
+        std::int32_t num_threads = 1;
+
+#pragma omp parallel num_threads(max_threads)
+        {
+            const std::int32_t thread_id = omp_get_thread_num();
+            std::int64_t* histogram = histograms.data() + static_cast<std::size_t>(thread_id) * 256;
+
+#pragma omp single
+            num_threads = omp_get_num_threads();
+
+            // every thread counts a contiguous, static chunk of the input
+#pragma omp for schedule(static)
+            for (std::int64_t i = 0; i < count; ++i) {
+                histogram[(keys[i] >> shift) & 0xffu]++;
+            }
+
+            // exclusive prefix sum over (digit, thread), keeps the sort stable
+#pragma omp single
+            {
+                std::int64_t offset = 0;
+                for (std::int32_t digit = 0; digit < 256; ++digit) {
+                    for (std::int32_t thread = 0; thread < num_threads; ++thread) {
+                        std::int64_t bucket_count = histograms[static_cast<std::size_t>(thread) * 256 + digit];
+                        histograms[static_cast<std::size_t>(thread) * 256 + digit] = offset;
+                        offset += bucket_count;
+                    }
+                }
+            }
+
+            // same static schedule as above, so each thread scatters the chunk it counted
+#pragma omp for schedule(static)
+            for (std::int64_t i = 0; i < count; ++i) {
+                std::int64_t target = histogram[(keys[i] >> shift) & 0xffu]++;
+                keys_buffer[target] = keys[i];
+                values_buffer[target] = values[i];
+            }
+        }
+
+        keys.swap(keys_buffer);
+        values.swap(values_buffer);
+    }
+}
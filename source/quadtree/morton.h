@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "structures/bounding_box.h"
+
+// Z-order (Morton) keys over a bounding box. Each axis is quantized to 32 bits
+// and the bits are interleaved with x in the even and y in the odd positions,
+// so the two most significant bits of a key are the quadrant of the root
+// (0 bottom-left, 1 bottom-right, 2 top-left, 3 top-right), the next two bits
+// the quadrant within that quadrant and so on.
+namespace Morton {
+    static const std::int32_t max_level = 32;
+
+    [[nodiscard]] std::uint64_t encode(double x, double y, const BoundingBox& bounding_box);
+
+    // quadrant of the key at the given tree level (level 0 = children of the root)
+    [[nodiscard]] inline std::uint32_t quadrant(std::uint64_t key, std::int32_t level){
+        return static_cast<std::uint32_t>((key >> (62 - 2 * level)) & 3u);
+    }
+
+    // Parallel LSD radix sort of keys with 8 bit digits. values are permuted
+    // alongside the keys. Digits that are equal for all keys are skipped.
+    void parallel_radix_sort(std::vector<std::uint64_t>& keys, std::vector<std::int32_t>& values);
+}
@@ -0,0 +1,80 @@
+#include "node_arena.h"
+
+#include <cassert>
+#include <stdexcept>
+
+std::atomic<std::uint64_t> QuadtreeNodeArena::next_arena_id{1};
+
+QuadtreeNodeArena::~QuadtreeNodeArena() {
+    for (auto& entry : states) {
+        for (QuadtreeNode* chunk : entry.second->chunks) {
+            ::operator delete(chunk, std::align_val_t(alignof(QuadtreeNode)));
+        }
+    }
+}
+
+QuadtreeNodeArena::ThreadState& QuadtreeNodeArena::local_state() {
+    // fast path: the thread used this arena last
+    thread_local std::uint64_t cached_arena_id = 0;
+    thread_local ThreadState* cached_state = nullptr;
+    if (cached_arena_id == arena_id) {
+        return *cached_state;
+    }
+
+    // slow path: find or register the state of this thread
+    std::lock_guard<std::mutex> lock(states_mutex);
+    std::thread::id thread_id = std::this_thread::get_id();
+    ThreadState* state = nullptr;
+    for (auto& entry : states) {
+        if (entry.first == thread_id) {
+            state = entry.second.get();
+            break;
+        }
+    }
+    if (state == nullptr) {
+        states.emplace_back(thread_id, std::make_unique<ThreadState>());
+        state = states.back().second.get();
+    }
+    cached_arena_id = arena_id;
+    cached_state = state;
+    return *state;
+}
+
+void QuadtreeNodeArena::reset() {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    for (auto& entry : states) {
+        entry.second->current_chunk = 0;
+        entry.second->used = 0;
+    }
+}
+
+void QuadtreeNodeArena::acquire(const void* new_owner) {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    if (owner != nullptr) {
+        throw std::logic_error("the node arena is still used by another quadtree");
+    }
+    owner = new_owner;
+}
+
+// called from the destructor of the tree, so a foreign owner is only checked in
+// debug builds instead of throwing like acquire
+void QuadtreeNodeArena::release([[maybe_unused]] const void* old_owner) {
+    assert(owner == old_owner && "the node arena is released by a tree that does not hold it");
+    reset();
+    std::lock_guard<std::mutex> lock(states_mutex);
+    owner = nullptr;
+}
+
+QuadtreeNodeArena& QuadtreeNodeArena::epoch_arena() {
+    thread_local QuadtreeNodeArena arena;
+    return arena;
+}
+
+std::size_t QuadtreeNodeArena::reserved_chunks() {
+    std::lock_guard<std::mutex> lock(states_mutex);
+    std::size_t chunks = 0;
+    for (auto& entry : states) {
+        chunks += entry.second->chunks.size();
+    }
+    return chunks;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "quadtreeNode.h"
+
+// Bump allocator that owns all nodes of a Quadtree. Every thread allocates from
+// its own chunks, so the parallel construction modes never contend on the heap.
+// reset() releases all nodes at once in O(threads) and keeps the chunks, so an
+// arena that is reused across epochs stops allocating after the first tree.
+class QuadtreeNodeArena {
+public:
+    QuadtreeNodeArena(): arena_id(next_arena_id.fetch_add(1)) {}
+    ~QuadtreeNodeArena();
+
+    QuadtreeNodeArena(const QuadtreeNodeArena&) = delete;
+    QuadtreeNodeArena& operator=(const QuadtreeNodeArena&) = delete;
+
+    template <typename... Args> QuadtreeNode* create(Args&&... args) {
+        ThreadState& state = local_state();
+        if (state.used == nodes_per_chunk) {
+            state.current_chunk++;
+            state.used = 0;
+        }
+        if (state.current_chunk == state.chunks.size()) {
+            state.chunks.push_back(static_cast<QuadtreeNode*>(::operator new(nodes_per_chunk * sizeof(QuadtreeNode), std::align_val_t(alignof(QuadtreeNode)))));
+        }
+        QuadtreeNode* node = state.chunks[state.current_chunk] + state.used;
+        state.used++;
+        return new (node) QuadtreeNode(std::forward<Args>(args)...);
+    }
+
+    // drops every node, the memory stays reserved for the next tree
+    void reset();
+
+    // An arena serves one live tree at a time. A tree acquires the arena when it
+    // is built and releases it, dropping all nodes, when it is destroyed.
+    // Acquiring an arena that another tree still holds throws std::logic_error.
+    void acquire(const void* owner);
+    void release(const void* owner);
+
+    // Arena for the tree that a simulation builds every epoch. Its nodes are
+    // recycled, so after the first epoch building the tree does not allocate
+    // nodes anymore. Every calling thread gets its own arena, so simulations
+    // that run on different threads never hold the same one.
+    static QuadtreeNodeArena& epoch_arena();
+
+    // number of chunks held by all threads, for diagnostics and tests
+    [[nodiscard]] std::size_t reserved_chunks();
+
+    static const std::size_t nodes_per_chunk = 4096;
+
+private:
+    static_assert(std::is_trivially_destructible_v<QuadtreeNode>, "arena nodes are released without running destructors");
+
+    struct ThreadState {
+        std::vector<QuadtreeNode*> chunks;
+        std::size_t current_chunk = 0;
+        std::size_t used = 0;
+    };
+
+    ThreadState& local_state();
+
+    static std::atomic<std::uint64_t> next_arena_id;
+
+    const std::uint64_t arena_id;
+    const void* owner = nullptr;
+    std::mutex states_mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<ThreadState>>> states;
+};
@@ -1,28 +1,75 @@
 #include "quadtree.h"
 
 #include "quadtreeNode.h"
+#include "morton.h"
 #include <set>
 #include <algorithm>
 #include <stdexcept>
 #include <omp.h>
 
-//Cut-Off-Wert fr construct_task_with_cutoff
-const int cutoff_threshold = 5000;
+// Adds the quadrupole of a point mass at offset d from the expansion center,
+// Q_ij = m * (3 d_i d_j - |d|^2 delta_ij) for the in-plane components
+static void add_point_quadrupole(double (&quadrupole)[3], double mass, const Vector2d<double>& d) {
+    double d_squared = d.norm2();
+    quadrupole[0] += mass * (3.0 * d.x * d.x - d_squared);
+    quadrupole[1] += mass * (3.0 * d.x * d.y);
+    quadrupole[2] += mass * (3.0 * d.y * d.y - d_squared);
+}
+
+// Monopole and quadrupole moments of an internal node from its finished
+// children. Called as the build recursion unwinds, so the tree is complete
+// without further passes. Child quadrupoles are shifted to the new center of
+// mass with the parallel axis theorem.
+static void accumulate_moments(QuadtreeNode* node) {
+    node->cumulative_mass = 0.0;
+    Vector2d<double> weighted_position(0.0, 0.0);
+    for (QuadtreeNode* child : node->children) {
+        node->cumulative_mass += child->cumulative_mass;
+        weighted_position += child->center_of_mass * child->cumulative_mass;
+    }
+    node->center_of_mass = node->cumulative_mass > 0 ? weighted_position / node->cumulative_mass : Vector2d<double>(0.0, 0.0);
+
+    double quadrupole[3] = {0.0, 0.0, 0.0};
+    for (QuadtreeNode* child : node->children) {
+        quadrupole[0] += child->quadrupole[0];
+        quadrupole[1] += child->quadrupole[1];
+        quadrupole[2] += child->quadrupole[2];
+        add_point_quadrupole(quadrupole, child->cumulative_mass, child->center_of_mass - node->center_of_mass);
+    }
+    std::copy(quadrupole, quadrupole + 3, node->quadrupole);
 
+    node->cumulative_mass_ready = true;
+    node->center_of_mass_ready = true;
+}
+
+Quadtree::Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode, std::int32_t arg_leaf_capacity)
+    : leaf_capacity(arg_leaf_capacity), owned_arena(std::make_unique<QuadtreeNodeArena>()) {
+    arena = owned_arena.get();
+    arena->acquire(this);
+    build(universe, bounding_box, arg_construct_mode);
+}
 
-Quadtree::Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t construct_mode) {
-    root = new QuadtreeNode(bounding_box);  // Initialisiere den Wurzelknoten
+Quadtree::Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode, QuadtreeNodeArena& node_arena, std::int32_t arg_leaf_capacity)
+    : leaf_capacity(arg_leaf_capacity), arena(&node_arena) {
+    arena->acquire(this);
+    build(universe, bounding_box, arg_construct_mode);
+}
+
+void Quadtree::build(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode) {
+    construct_mode = arg_construct_mode;
+    migrated_bodies = 0;
+    root = arena->create(bounding_box);  // Initialisiere den Wurzelknoten
 
     // Liste der Indizes der Himmelskrper innerhalb der BoundingBox erstellen
-    std::vector<std::int32_t> body_indices;
+    body_indices.clear();
 
     // Durchlaufe alle Himmelskrper im Universum
     for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
         const Vector2d<double>& position = universe.positions[i];
 
         // berprfe, ob der Krper innerhalb der BoundingBox liegt
-        if (position[0] >= bounding_box.x_min && position[0] <= bounding_box.x_max &&
-            position[1] >= bounding_box.y_min && position[1] <= bounding_box.y_max) {
+        if (position.x >= bounding_box.x_min && position.x <= bounding_box.x_max &&
+            position.y >= bounding_box.y_min && position.y <= bounding_box.y_max) {
             body_indices.push_back(i);  // Fge den Krperindex zur Liste hinzu
         }
     }
@@ -38,16 +85,27 @@ Quadtree::Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t con
     case 2:
         root->children = construct_task_with_cutoff(universe, bounding_box, body_indices);
         break;
+    case 3:
+        root->children = construct_morton(universe, bounding_box, body_indices);
+        break;
     default:
         std::cerr << "Unbekannter Konstruktionmodus!" << std::endl;
         break;
     }
+
+    // die Kinder sind fertig, damit auch Masse und Schwerpunkt der Wurzel
+    accumulate_moments(root);
+
+    built_leaf_occupancy = leaf_occupancy();
 }
 
 Quadtree::~Quadtree() {
-    delete root;  // Lsche den Wurzelknoten und seine Kinder rekursiv
+    // Alle Knoten liegen in der Arena und werden gemeinsam freigegeben
+    arena->release(this);
 }
 
+// Masses and centers of mass are computed during construction, both calls only
+// complete nodes whose moments were reset by hand.
 void Quadtree::calculate_cumulative_masses() {
     root->calculate_node_cumulative_mass();
 }
@@ -57,232 +115,452 @@ void Quadtree::calculate_center_of_mass() {
 }
 
 
-std::vector<QuadtreeNode*> Quadtree::construct(Universe& universe, BoundingBox BB, std::vector<std::int32_t> body_indices) {
-    std::vector<QuadtreeNode*> nodes;
+// Partitions the index range of BB in place into its four quadrants. Afterwards
+// body_indices holds bottom-left, bottom-right, top-left and top-right bodies
+// back to back and quadrants[i] views the part belonging to childBBs[i].
+static void partition_quadrants(Universe& universe, const BoundingBox& BB, std::span<std::int32_t> body_indices, std::span<std::int32_t> (&quadrants)[4], BoundingBox (&childBBs)[4]) {
+    double x_mid = (BB.x_min + BB.x_max) / 2.0;
+    double y_mid = (BB.y_min + BB.y_max) / 2.0;
+
+    childBBs[0] = BoundingBox(BB.x_min, x_mid, BB.y_min, y_mid);  // Bottom-left
+    childBBs[1] = BoundingBox(x_mid, BB.x_max, BB.y_min, y_mid);  // Bottom-right
+    childBBs[2] = BoundingBox(BB.x_min, x_mid, y_mid, BB.y_max);  // Top-left
+    childBBs[3] = BoundingBox(x_mid, BB.x_max, y_mid, BB.y_max);  // Top-right
+
+    // split bottom from top, then left from right within both halves
+    auto first = body_indices.begin();
+    auto last = body_indices.end();
+    auto top = std::partition(first, last, [&](std::int32_t idx) { return universe.positions[idx].y < y_mid; });
+    auto bottom_right = std::partition(first, top, [&](std::int32_t idx) { return universe.positions[idx].x < x_mid; });
+    auto top_right = std::partition(top, last, [&](std::int32_t idx) { return universe.positions[idx].x < x_mid; });
+
+    quadrants[0] = std::span<std::int32_t>(first, bottom_right);
+    quadrants[1] = std::span<std::int32_t>(bottom_right, top);
+    quadrants[2] = std::span<std::int32_t>(top, top_right);
+    quadrants[3] = std::span<std::int32_t>(top_right, last);
+}
 
-    // Wenn nur ein Krper im Quadranten ist, erstellen wir einen Blattknoten
-    if (body_indices.size() == 1) {
-        QuadtreeNode* node = new QuadtreeNode(BB);
-        node->body_identifier = body_indices[0];  // Setze den Krperindex im Blattknoten
+// Bodies that share a position can not be separated by halving the box
+static bool can_subdivide(const BoundingBox& BB) {
+    double x_mid = (BB.x_min + BB.x_max) / 2.0;
+    double y_mid = (BB.y_min + BB.y_max) / 2.0;
+    return (BB.x_min < x_mid && x_mid < BB.x_max) || (BB.y_min < y_mid && y_mid < BB.y_max);
+}
 
-        // Calculate and store the cumulative mass and center of mass for leaf nodes
-        node->cumulative_mass = universe.weights[body_indices[0]];
-        node->center_of_mass = universe.positions[body_indices[0]];
-        node->cumulative_mass_ready = true;
-        node->center_of_mass_ready = true;
+// Mass and center of mass of a leaf from its bodies. A leaf emptied by
+// Quadtree::update has no mass and no identifying body.
+static void leaf_moments(Universe& universe, QuadtreeNode* node) {
+    node->body_identifier = node->bodies.empty() ? -1 : node->bodies[0];
 
-        nodes.push_back(node);
+    if (node->bodies.size() == 1) {
+        node->cumulative_mass = universe.weights[node->bodies[0]];
+        node->center_of_mass = universe.positions[node->bodies[0]];
     }
     else {
-        // Wenn mehr als ein Krper im Quadranten ist, teilen wir den Raum in 4 Subquadranten
-
-        // Berechne die Grenzen fr die Subquadranten
-        double x_mid = (BB.x_min + BB.x_max) / 2.0;
-        double y_mid = (BB.y_min + BB.y_max) / 2.0;
-
-        // Subquadranten erstellen
-        BoundingBox childBBs[4] = {
-            BoundingBox(BB.x_min, x_mid, BB.y_min, y_mid),  // links unten
-            BoundingBox(x_mid, BB.x_max, BB.y_min, y_mid),  // rechts unten
-            BoundingBox(BB.x_min, x_mid, y_mid, BB.y_max),  // links oben
-            BoundingBox(x_mid, BB.x_max, y_mid, BB.y_max)   // rechts oben
-        };
-
-        // Indizes der Himmelskrper in den Subquadranten aufteilen
-        std::vector<std::int32_t> child_indices[4];
-
-        for (auto idx : body_indices) {
-            const Vector2d<double>& pos = universe.positions[idx];
-            if (pos[0] < x_mid) {
-                if (pos[1] < y_mid)
-                    child_indices[0].push_back(idx);  // links unten
-                else
-                    child_indices[2].push_back(idx);  // links oben
-            }
-            else {
-                if (pos[1] < y_mid)
-                    child_indices[1].push_back(idx);  // rechts unten
-                else
-                    child_indices[3].push_back(idx);  // rechts oben
-            }
+        // Iteriere ber alle Krper im Quadranten und addiere ihre Massen + berechne den gewichteten Massenschwerpunkt
+        node->cumulative_mass = 0.0;
+        Vector2d<double> weighted_position(0.0, 0.0);
+        for (std::int32_t body_index : node->bodies) {
+            node->cumulative_mass += universe.weights[body_index];
+            weighted_position += universe.positions[body_index] * universe.weights[body_index];
         }
+        node->center_of_mass = node->cumulative_mass > 0 ? weighted_position / node->cumulative_mass : Vector2d<double>(0.0, 0.0);
+    }
 
-        // Rekursiver Aufruf fr die Subquadranten
-        for (int i = 0; i < 4; ++i) {
-            if (!child_indices[i].empty()) {
-                std::vector<QuadtreeNode*> children = construct(universe, childBBs[i], child_indices[i]);
-                QuadtreeNode* internal_node = new QuadtreeNode(BB);  // Erstelle einen internen Knoten
-                internal_node->children = children;  // Setze die Subquadranten als Kinder
-                nodes.push_back(internal_node);
-            }
+    double quadrupole[3] = {0.0, 0.0, 0.0};
+    if (node->bodies.size() > 1) {
+        for (std::int32_t body_index : node->bodies) {
+            add_point_quadrupole(quadrupole, universe.weights[body_index], universe.positions[body_index] - node->center_of_mass);
         }
     }
+    std::copy(quadrupole, quadrupole + 3, node->quadrupole);
 
-    return nodes;
+    node->cumulative_mass_ready = true;
+    node->center_of_mass_ready = true;
 }
 
-std::vector<QuadtreeNode*> Quadtree::construct_task(Universe& universe, BoundingBox BB, std::vector<std::int32_t> body_indices) {
-    std::vector<QuadtreeNode*> nodes;
+// Leaf for the given bodies. The first body identifies the leaf, mass and center
+// of mass cover all of them and the leaf keeps the range for exact near-field sums.
+static QuadtreeNode* create_leaf(QuadtreeNodeArena& arena, Universe& universe, const BoundingBox& BB, std::span<const std::int32_t> body_indices) {
+    QuadtreeNode* node = arena.create(BB);
+    node->bodies = body_indices;
+    leaf_moments(universe, node);
+    return node;
+}
 
-    // If there's only one body in this quadrant, create a leaf node
-    if (body_indices.size() == 1) {
-        QuadtreeNode* node = new QuadtreeNode(BB);
-        node->body_identifier = body_indices[0]; // Set the body index in the leaf node
+QuadtreeNode::ChildList Quadtree::construct(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices) {
+    QuadtreeNode::ChildList nodes;
 
-        // Calculate and store the cumulative mass and center of mass for leaf nodes
-        node->cumulative_mass = universe.weights[body_indices[0]];
-        node->center_of_mass = universe.positions[body_indices[0]];
-        node->cumulative_mass_ready = true;
-        node->center_of_mass_ready = true;
+    // Indizes der Himmelskrper in den Subquadranten aufteilen, ohne Kopien
+    std::span<std::int32_t> quadrants[4];
+    BoundingBox childBBs[4];
+    partition_quadrants(universe, BB, arg_body_indices, quadrants, childBBs);
 
-        nodes.push_back(node);
+    for (int i = 0; i < 4; ++i) {
+        if (quadrants[i].empty()) {
+            continue;
+        }
+        // Wenn nur ein Krper im Quadranten ist, erstellen wir einen Blattknoten
+        if (quadrants[i].size() == 1 || !can_subdivide(childBBs[i])) {
+            nodes.push_back(create_leaf(*arena, universe, childBBs[i], quadrants[i]));
+            continue;
+        }
+        // Rekursiver Aufruf fr die Subquadranten
+        QuadtreeNode* internal_node = arena->create(childBBs[i]);
+        internal_node->children = construct(universe, childBBs[i], quadrants[i]);
+        accumulate_moments(internal_node);
+        nodes.push_back(internal_node);
     }
-    else {
-        // More than one body: split the space into 4 sub-quadrants
-        double x_mid = (BB.x_min + BB.x_max) / 2.0;
-        double y_mid = (BB.y_min + BB.y_max) / 2.0;
-
-        BoundingBox childBBs[4] = {
-            BoundingBox(BB.x_min, x_mid, BB.y_min, y_mid),  // Bottom-left
-            BoundingBox(x_mid, BB.x_max, BB.y_min, y_mid),  // Bottom-right
-            BoundingBox(BB.x_min, x_mid, y_mid, BB.y_max),  // Top-left
-            BoundingBox(x_mid, BB.x_max, y_mid, BB.y_max)   // Top-right
-        };
-
-        // Allocate child body indices
-        std::vector<std::int32_t> child_indices[4];
-        for (auto idx : body_indices) {
-            const Vector2d<double>& pos = universe.positions[idx];
-            if (pos[0] < x_mid) {
-                if (pos[1] < y_mid)
-                    child_indices[0].push_back(idx); // Bottom-left
-                else
-                    child_indices[2].push_back(idx); // Top-left
-            }
-            else {
-                if (pos[1] < y_mid)
-                    child_indices[1].push_back(idx); // Bottom-right
-                else
-                    child_indices[3].push_back(idx); // Top-right
-            }
+
+    return nodes;
+}
+
+// quadrants below this size are built by the task that partitioned them
+static const std::size_t build_task_grain = 4096;
+
+// Task-parallel build shared by construct_task and construct_task_with_cutoff,
+// called from inside a single region. Every large quadrant becomes an OpenMP
+// task, idle threads of the team pick up pending subtrees, so skewed inputs
+// keep all threads busy without nested parallel regions. Quadrants of at most
+// max_leaf_size bodies become leaves.
+static QuadtreeNode::ChildList construct_subtree_tasks(QuadtreeNodeArena& arena, Universe& universe, BoundingBox BB, std::span<std::int32_t> body_indices, std::size_t max_leaf_size) {
+    // Partition the body indices into the 4 sub-quadrants in place
+    std::span<std::int32_t> quadrants[4];
+    BoundingBox childBBs[4];
+    partition_quadrants(universe, BB, body_indices, quadrants, childBBs);
+
+    // one slot per quadrant, each task writes only its own
+    QuadtreeNode* slots[4] = {nullptr, nullptr, nullptr, nullptr};
+
+    for (int i = 0; i < 4; ++i) {
+        if (quadrants[i].empty()) {
+            continue;
         }
+        if (quadrants[i].size() <= max_leaf_size || !can_subdivide(childBBs[i])) {
+            slots[i] = create_leaf(arena, universe, childBBs[i], quadrants[i]);
+            continue;
+        }
+        QuadtreeNode* internal_node = arena.create(childBBs[i]);
+        slots[i] = internal_node;
+#pragma omp task if(quadrants[i].size() > build_task_grain) firstprivate(internal_node, i) shared(arena, universe, childBBs, quadrants)
+        {
+            internal_node->children = construct_subtree_tasks(arena, universe, childBBs[i], quadrants[i], max_leaf_size);
+            accumulate_moments(internal_node);
+        }
+    }
+#pragma omp taskwait
+
+    // Skip the slots of empty quadrants
+    QuadtreeNode::ChildList nodes;
+    for (QuadtreeNode* slot : slots) {
+        if (slot != nullptr) {
+            nodes.push_back(slot);
+        }
+    }
+    return nodes;
+}
 
-        // Preallocate space for nodes to avoid thread-safety issues
-        nodes.resize(4, nullptr);
+QuadtreeNode::ChildList Quadtree::construct_task(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices) {
+    // one team for the whole build, the recursion only spawns tasks
+    QuadtreeNode::ChildList nodes;
+#pragma omp parallel
+#pragma omp single
+    nodes = construct_subtree_tasks(*arena, universe, BB, arg_body_indices, 1);
 
-        // Parallelize the processing of sub-quadrants
-#pragma omp parallel for
-        for (int i = 0; i < 4; ++i) {
-            if (!child_indices[i].empty()) {
-                // Recursively construct the quadtree for this sub-quadrant
-                std::vector<QuadtreeNode*> children = construct_task(universe, childBBs[i], child_indices[i]);
+    return nodes;
+}
+
+QuadtreeNode::ChildList Quadtree::construct_task_with_cutoff(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices) {
+    // like construct_task, but quadrants that fit into one bucket become leaves
+    QuadtreeNode::ChildList nodes;
+#pragma omp parallel
+#pragma omp single
+    nodes = construct_subtree_tasks(*arena, universe, BB, arg_body_indices, static_cast<std::size_t>(leaf_capacity));
+
+    return nodes;
+}
 
-                // Create an internal node for this quadrant
-                QuadtreeNode* internal_node = new QuadtreeNode(BB);
-                internal_node->children = children;
+// ranges below this size are emitted by the task that found them
+static const std::int64_t morton_task_grain = 4096;
+
+// Emits the children of the node that covers the sorted key range [begin, end)
+// at the given level. The range of each child is found by a binary search for
+// the quadrant digit of the level, so no index lists are copied.
+static QuadtreeNode::ChildList construct_morton_children(QuadtreeNodeArena& arena, Universe& universe, BoundingBox BB, const std::uint64_t* keys, const std::int32_t* indices, std::int64_t begin, std::int64_t end, std::int32_t level) {
+    double x_mid = (BB.x_min + BB.x_max) / 2.0;
+    double y_mid = (BB.y_min + BB.y_max) / 2.0;
+    BoundingBox childBBs[4] = {
+        BoundingBox(BB.x_min, x_mid, BB.y_min, y_mid),  // Bottom-left
+        BoundingBox(x_mid, BB.x_max, BB.y_min, y_mid),  // Bottom-right
+        BoundingBox(BB.x_min, x_mid, y_mid, BB.y_max),  // Top-left
+        BoundingBox(x_mid, BB.x_max, y_mid, BB.y_max)   // Top-right
+    };
+
+    // split points of the four quadrants within the sorted range
+    std::int64_t bounds[5];
+    bounds[0] = begin;
+    bounds[4] = end;
+    for (std::uint32_t quadrant = 1; quadrant < 4; ++quadrant) {
+        bounds[quadrant] = std::partition_point(keys + bounds[quadrant - 1], keys + end, [&](std::uint64_t key) {
+            return Morton::quadrant(key, level) < quadrant;
+        }) - keys;
+    }
 
-                // Safely assign the node to the preallocated vector
-                nodes[i] = internal_node;
+    QuadtreeNode* slots[4] = {nullptr, nullptr, nullptr, nullptr};
+    for (int i = 0; i < 4; ++i) {
+        std::int64_t child_begin = bounds[i];
+        std::int64_t child_end = bounds[i + 1];
+        if (child_begin == child_end) {
+            continue;
+        }
+
+        QuadtreeNode* node = arena.create(childBBs[i]);
+        slots[i] = node;
+
+        if (child_end - child_begin == 1 || level + 1 == Morton::max_level) {
+            // Leaf. Bodies sharing the full key can not be separated any further
+            // and are aggregated into one leaf like in construct_task_with_cutoff.
+            node->bodies = std::span<const std::int32_t>(indices + child_begin, indices + child_end);
+            leaf_moments(universe, node);
+        }
+        else {
+#pragma omp task if(child_end - child_begin > morton_task_grain) firstprivate(node, i, child_begin, child_end) shared(arena, universe, childBBs)
+            {
+                node->children = construct_morton_children(arena, universe, childBBs[i], keys, indices, child_begin, child_end, level + 1);
+                accumulate_moments(node);
             }
         }
+    }
+#pragma omp taskwait
+
+    QuadtreeNode::ChildList nodes;
+    for (QuadtreeNode* slot : slots) {
+        if (slot != nullptr) {
+            nodes.push_back(slot);
+        }
+    }
+    return nodes;
+}
 
-        // Remove nullptr entries (for empty quadrants)
-        nodes.erase(std::remove(nodes.begin(), nodes.end(), nullptr), nodes.end());
+QuadtreeNode::ChildList Quadtree::construct_morton(Universe& universe, BoundingBox& BB, std::vector<std::int32_t>& arg_body_indices) {
+    const std::int64_t count = static_cast<std::int64_t>(arg_body_indices.size());
+    if (count == 0) {
+        return QuadtreeNode::ChildList();
     }
 
+    // Morton keys relative to the root box, then one parallel radix sort
+    std::vector<std::uint64_t> keys(count);
+#pragma omp parallel for
+    for (std::int64_t i = 0; i < count; ++i) {
+        const Vector2d<double>& pos = universe.positions[arg_body_indices[i]];
+        keys[i] = Morton::encode(pos.x, pos.y, BB);
+    }
+    Morton::parallel_radix_sort(keys, arg_body_indices);
+
+    // the tree is read off the sorted key prefixes, large subtrees become tasks
+    QuadtreeNode::ChildList nodes;
+#pragma omp parallel
+#pragma omp single
+    nodes = construct_morton_children(*arena, universe, BB, keys.data(), arg_body_indices.data(), 0, count, 0);
+
     return nodes;
 }
 
+// subtrees above this depth are refitted as separate tasks
+static const std::int32_t refit_task_depth = 4;
+
+// Recomputes the moments of a subtree bottom-up, the structure is unchanged
+static void refit_moments(Universe& universe, QuadtreeNode* node, std::int32_t depth) {
+    if (node->children.empty()) {
+        leaf_moments(universe, node);
+        return;
+    }
+    for (QuadtreeNode* child : node->children) {
+#pragma omp task if(depth < refit_task_depth) firstprivate(child) shared(universe)
+        refit_moments(universe, child, depth + 1);
+    }
+#pragma omp taskwait
+    accumulate_moments(node);
+}
+
+// Quadrant of BB that the build assigns the position to, numbered as in partition_quadrants
+static int quadrant_index(const BoundingBox& BB, const Vector2d<double>& position) {
+    double x_mid = (BB.x_min + BB.x_max) / 2.0;
+    double y_mid = (BB.y_min + BB.y_max) / 2.0;
+    return (position.y < y_mid ? 0 : 2) + (position.x < x_mid ? 0 : 1);
+}
 
-std::vector<QuadtreeNode*> Quadtree::construct_task_with_cutoff(Universe& universe, BoundingBox& BB, std::vector<std::int32_t>& body_indices) {
-    std::vector<QuadtreeNode*> nodes;
+static BoundingBox quadrant_box(const BoundingBox& BB, int quadrant) {
+    double x_mid = (BB.x_min + BB.x_max) / 2.0;
+    double y_mid = (BB.y_min + BB.y_max) / 2.0;
+    bool right = quadrant & 1;
+    bool top = quadrant & 2;
+    return BoundingBox(right ? x_mid : BB.x_min, right ? BB.x_max : x_mid, top ? y_mid : BB.y_min, top ? BB.y_max : y_mid);
+}
 
-    // Base case: if the cutoff threshold is reached, create a leaf node
-    if (body_indices.size() <= cutoff_threshold) {
-        QuadtreeNode* node = new QuadtreeNode(BB);
-        node->body_identifier = body_indices[0];  // Set the body index in the leaf node
-        node->cumulative_mass = 0.0;
-        Vector2d<double> weighted_position(0.0, 0.0);
+static Vector2d<double> box_center(const BoundingBox& BB) {
+    return Vector2d<double>((BB.x_min + BB.x_max) / 2.0, (BB.y_min + BB.y_max) / 2.0);
+}
 
-        // Iteriere ber alle Krper im Quadranten und addiere ihre Massen + berechne den gewichteten Massenschwerpunkt
-        for (std::size_t i = 0; i < body_indices.size(); ++i) {
-            std::int32_t body_index = body_indices[i];
-            double body_mass = universe.weights[body_index];
-            const Vector2d<double>& body_position = universe.positions[body_index];
+bool Quadtree::grow_root(const Vector2d<double>& position) {
+    // double the root box towards the position, the old root becomes one quadrant
+    while (!root->bounding_box.contains(position)) {
+        const BoundingBox& BB = root->bounding_box;
+        double width = BB.x_max - BB.x_min;
+        double height = BB.y_max - BB.y_min;
+        if (!(width > 0 && height > 0)) {
+            return false;
+        }
+        bool left = position.x < BB.x_min;
+        bool down = position.y < BB.y_min;
+        QuadtreeNode* new_root = arena->create(BoundingBox(
+            left ? BB.x_min - width : BB.x_min, left ? BB.x_max : BB.x_max + width,
+            down ? BB.y_min - height : BB.y_min, down ? BB.y_max : BB.y_max + height));
+        new_root->children.push_back(root);
+        root = new_root;
+    }
+    return true;
+}
 
-            node->cumulative_mass += body_mass;
-            weighted_position = weighted_position + body_position * body_mass;
+bool Quadtree::insert(Universe& universe, std::int32_t* slot) {
+    const Vector2d<double>& position = universe.positions[*slot];
+    QuadtreeNode* node = root;
+
+    while (true) {
+        // children are matched by the quadrant of their center
+        int quadrant = quadrant_index(node->bounding_box, position);
+        QuadtreeNode* child = nullptr;
+        for (QuadtreeNode* candidate : node->children) {
+            if (quadrant_index(node->bounding_box, box_center(candidate->bounding_box)) == quadrant) {
+                child = candidate;
+            }
         }
 
-        // Berechne den Massenschwerpunkt des Quadranten
-        if (node->cumulative_mass > 0) {
-            node->center_of_mass = weighted_position / node->cumulative_mass;
+        // empty quadrant, the body becomes a leaf of its own
+        if (child == nullptr) {
+            node->children.push_back(create_leaf(*arena, universe, quadrant_box(node->bounding_box, quadrant), std::span<const std::int32_t>(slot, 1)));
+            return true;
         }
-        else {
-            // Falls keine Masse im Quadranten, setze center_of_mass auf einen Standardwert
-            node->center_of_mass = Vector2d<double>(0.0, 0.0);
+        if (!child->children.empty()) {
+            node = child;
+            continue;
+        }
+        // a leaf emptied by migration takes the body
+        if (child->bodies.empty()) {
+            child->bodies = std::span<const std::int32_t>(slot, 1);
+            return true;
+        }
+        if (!can_subdivide(child->bounding_box)) {
+            return false;
         }
 
-        node->cumulative_mass_ready = true;
-        node->center_of_mass_ready = true;
+        // split the leaf, its bodies are contiguous and are partitioned in place
+        std::int32_t* first = body_indices.data() + (child->bodies.data() - body_indices.data());
+        std::span<std::int32_t> leaf_bodies(first, child->bodies.size());
+        std::span<std::int32_t> quadrants[4];
+        BoundingBox childBBs[4];
+        partition_quadrants(universe, child->bounding_box, leaf_bodies, quadrants, childBBs);
 
-        nodes.push_back(node);
-    }
-    else {
-        // Calculate the boundaries for the 4 subquadrants
-        double x_mid = (BB.x_min + BB.x_max) / 2.0;
-        double y_mid = (BB.y_min + BB.y_max) / 2.0;
-
-        // Define the bounding boxes for the 4 subquadrants
-        BoundingBox childBBs[4] = {
-            BoundingBox(BB.x_min, x_mid, BB.y_min, y_mid),  // Bottom-left
-            BoundingBox(x_mid, BB.x_max, BB.y_min, y_mid),  // Bottom-right
-            BoundingBox(BB.x_min, x_mid, y_mid, BB.y_max),  // Top-left
-            BoundingBox(x_mid, BB.x_max, y_mid, BB.y_max)   // Top-right
-        };
-
-        // Distribute the body indices into the 4 subquadrants
-        std::vector<std::int32_t> child_indices[4];
-        for (auto idx : body_indices) {
-            const Vector2d<double>& pos = universe.positions[idx];
-            if (pos[0] < x_mid) {
-                if (pos[1] < y_mid)
-                    child_indices[0].push_back(idx);  // Bottom-left
-                else
-                    child_indices[2].push_back(idx);  // Top-left
-            }
-            else {
-                if (pos[1] < y_mid)
-                    child_indices[1].push_back(idx);  // Bottom-right
-                else
-                    child_indices[3].push_back(idx);  // Top-right
+        child->bodies = std::span<const std::int32_t>();
+        child->body_identifier = -1;
+        for (int i = 0; i < 4; ++i) {
+            if (!quadrants[i].empty()) {
+                child->children.push_back(create_leaf(*arena, universe, childBBs[i], quadrants[i]));
             }
         }
+        node = child;
+    }
+}
 
-        // Parallelize the construction of subquadrants
-        std::vector<QuadtreeNode*> children[4];
+double Quadtree::leaf_occupancy() const {
+    std::size_t occupied_leaves = 0;
+    std::vector<const QuadtreeNode*> stack = {root};
+    while (!stack.empty()) {
+        const QuadtreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->children.empty() && !node->bodies.empty()) {
+            occupied_leaves++;
+        }
+        for (const QuadtreeNode* child : node->children) {
+            stack.push_back(child);
+        }
+    }
+    return occupied_leaves > 0 ? static_cast<double>(body_indices.size()) / occupied_leaves : 0.0;
+}
 
-#pragma omp parallel for shared(children, childBBs, child_indices)
-        for (int i = 0; i < 4; ++i) {
-            if (!child_indices[i].empty()) {
-                // Recursively construct the subtree for each non-empty subquadrant
-                children[i] = construct_task_with_cutoff(universe, childBBs[i], child_indices[i]);
-            }
+bool Quadtree::update(Universe& universe, double max_migrated_fraction, double min_leaf_occupancy) {
+    if (universe.num_bodies != body_indices.size()) {
+        arena->reset();
+        build(universe, universe.get_bounding_box(), construct_mode);
+        return true;
+    }
+
+    // collect the leaves
+    std::vector<QuadtreeNode*> leaves;
+    std::vector<QuadtreeNode*> stack = {root};
+    while (!stack.empty()) {
+        QuadtreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->children.empty()) {
+            leaves.push_back(node);
+        }
+        for (QuadtreeNode* child : node->children) {
+            stack.push_back(child);
         }
+    }
 
-        // Combine the child nodes into a single internal node
-        QuadtreeNode* internal_node = new QuadtreeNode(BB);
-        for (int i = 0; i < 4; ++i) {
-            if (!children[i].empty()) {
-                for (QuadtreeNode* child : children[i]) {
-                    internal_node->children.push_back(child);
-                }
+    // Bodies that left their leaf are moved to the end of its range and the
+    // leaf shrinks to the bodies that stayed. The index slots of the migrated
+    // bodies are reinserted below, each as a range of one.
+    std::vector<std::int32_t*> migrated;
+#pragma omp parallel
+    {
+        std::vector<std::int32_t*> local_migrated;
+#pragma omp for schedule(dynamic, 256)
+        for (std::size_t l = 0; l < leaves.size(); ++l) {
+            QuadtreeNode* leaf = leaves[l];
+            std::int32_t* first = body_indices.data() + (leaf->bodies.data() - body_indices.data());
+            std::int32_t* last = first + leaf->bodies.size();
+            std::int32_t* stay_end = std::partition(first, last, [&](std::int32_t idx) {
+                return leaf->bounding_box.contains(universe.positions[idx]);
+            });
+            for (std::int32_t* slot = stay_end; slot < last; ++slot) {
+                local_migrated.push_back(slot);
             }
+            leaf->bodies = std::span<const std::int32_t>(first, stay_end);
         }
-        nodes.push_back(internal_node);
+#pragma omp critical
+        migrated.insert(migrated.end(), local_migrated.begin(), local_migrated.end());
     }
 
-    return nodes;
+    // too many migrations leave a fragmented tree, build it anew
+    migrated_bodies += static_cast<std::uint32_t>(migrated.size());
+    if (migrated_bodies > max_migrated_fraction * universe.num_bodies) {
+        arena->reset();
+        build(universe, universe.get_bounding_box(), construct_mode);
+        return true;
+    }
+
+    for (std::int32_t* slot : migrated) {
+        if (!grow_root(universe.positions[*slot]) || !insert(universe, slot)) {
+            arena->reset();
+            build(universe, universe.get_bounding_box(), construct_mode);
+            return true;
+        }
+    }
+
+    // the split leaves make the walk open more leaves for the same bodies
+    if (leaf_occupancy() < min_leaf_occupancy * built_leaf_occupancy) {
+        arena->reset();
+        build(universe, universe.get_bounding_box(), construct_mode);
+        return true;
+    }
+
+#pragma omp parallel
+#pragma omp single
+    refit_moments(universe, root, 0);
+
+    return false;
 }
 
 std::vector<BoundingBox> Quadtree::get_bounding_boxes(QuadtreeNode* qtn) {
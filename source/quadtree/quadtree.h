@@ -3,19 +3,72 @@
 #include "structures/vector2d.h"
 #include "structures/universe.h"
 #include "quadtreeNode.h"
+#include "node_arena.h"
+
+#include <memory>
+#include <span>
 
 class Quadtree {
 public:
-    Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t construct_mode);
+    // arg_leaf_capacity is the number of bodies a bucket leaf may hold in construct
+    // mode 2; the other modes store one body per leaf
+    Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode, std::int32_t arg_leaf_capacity = default_leaf_capacity);
+    // Allocates the nodes from an external arena, which is reset when the tree
+    // is destroyed. Reusing one arena across epochs avoids all node allocations.
+    // The arena must not be held by another live tree.
+    Quadtree(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode, QuadtreeNodeArena& node_arena, std::int32_t arg_leaf_capacity = default_leaf_capacity);
     ~Quadtree();
 
-    std::vector<QuadtreeNode*> construct(Universe& universe, BoundingBox BB, std::vector<std::int32_t> body_indices);
-    std::vector<QuadtreeNode*> construct_task(Universe& universe, BoundingBox BB, std::vector<std::int32_t> body_indices);
-    std::vector<QuadtreeNode*> construct_task_with_cutoff(Universe& universe, BoundingBox& BB, std::vector<std::int32_t>& body_indices);
+    Quadtree(const Quadtree&) = delete;
+    Quadtree& operator=(const Quadtree&) = delete;
+
+    // The construct functions return the children of the node covering BB. They
+    // partition arg_body_indices in place, each child recurses on its own sub-span.
+    // construct_task and construct_task_with_cutoff build large subtrees as
+    // OpenMP tasks within one parallel region.
+    QuadtreeNode::ChildList construct(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices);
+    QuadtreeNode::ChildList construct_task(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices);
+    QuadtreeNode::ChildList construct_task_with_cutoff(Universe& universe, BoundingBox BB, std::span<std::int32_t> arg_body_indices);
+    QuadtreeNode::ChildList construct_morton(Universe& universe, BoundingBox& BB, std::vector<std::int32_t>& arg_body_indices);
 
     void calculate_cumulative_masses();
     void calculate_center_of_mass();
+
+    // Brings the tree up to date with the moved bodies of the next epoch. Bodies
+    // still inside their leaf only need the moments refitted, bodies that left
+    // it are reinserted into the cell now containing them, the root grows for
+    // bodies that left it. Once more than max_migrated_fraction of all bodies
+    // migrated since the last build the tree is rebuilt. Reinsertions split
+    // leaves into sparsely filled ones, so the tree is also rebuilt once the
+    // mean number of bodies per occupied leaf drops below min_leaf_occupancy
+    // times its value after the last build. Returns true on a rebuild.
+    bool update(Universe& universe, double max_migrated_fraction = default_max_migrated_fraction, double min_leaf_occupancy = default_min_leaf_occupancy);
     QuadtreeNode* root = nullptr;
 
+    static constexpr std::int32_t default_leaf_capacity = 16;
+    std::int32_t leaf_capacity = default_leaf_capacity;
+
+    static constexpr double default_max_migrated_fraction = 0.02;
+    // bodies reinserted by update since the last build
+    std::uint32_t migrated_bodies = 0;
+
+    static constexpr double default_min_leaf_occupancy = 0.5;
+    // mean number of bodies per occupied leaf after the last build
+    double built_leaf_occupancy = 0.0;
+
+    // all bodies of the tree, leaves reference contiguous ranges of it
+    std::vector<std::int32_t> body_indices;
+
     std::vector<BoundingBox> get_bounding_boxes(QuadtreeNode* qtn);
+
+private:
+    void build(Universe& universe, BoundingBox bounding_box, std::int8_t arg_construct_mode);
+    bool insert(Universe& universe, std::int32_t* slot);
+    bool grow_root(const Vector2d<double>& position);
+    [[nodiscard]] double leaf_occupancy() const;
+
+    std::int8_t construct_mode = 0;
+
+    std::unique_ptr<QuadtreeNodeArena> owned_arena;
+    QuadtreeNodeArena* arena = nullptr;
 };
\ No newline at end of file
@@ -28,14 +28,11 @@ double QuadtreeNode::calculate_node_cumulative_mass() {
 }
 
 QuadtreeNode::QuadtreeNode(BoundingBox arg_bounding_box)
-    : bounding_box(arg_bounding_box), body_identifier(-1), cumulative_mass(0.0),
-    cumulative_mass_ready(false), center_of_mass_ready(false) {}
-
-QuadtreeNode::~QuadtreeNode() {
-    for (QuadtreeNode* child : children) {
-        delete child;
-    }
-    children.clear();
+    : cumulative_mass(0.0), body_identifier(-1),
+    center_of_mass_ready(false), cumulative_mass_ready(false), bounding_box(arg_bounding_box) {
+    double width = bounding_box.x_max - bounding_box.x_min;
+    double height = bounding_box.y_max - bounding_box.y_min;
+    size_squared = width * width + height * height;
 }
 
 Vector2d<double> QuadtreeNode::calculate_node_center_of_mass() {
@@ -55,9 +52,9 @@ Vector2d<double> QuadtreeNode::calculate_node_center_of_mass() {
     Vector2d<double> weighted_position(0.0, 0.0);
 
     for (auto* child : children) {
-        // Rekursiv den Massenschwerpunkt jedes Kindes berechnen
+        // Rekursiv den Massenschwerpunkt jedes Kindes berechnen, dabei ist auch seine Masse fertig
         Vector2d<double> child_center_of_mass = child->calculate_node_center_of_mass();
-        double child_mass = child->calculate_node_cumulative_mass();
+        double child_mass = child->cumulative_mass;
 
         weighted_position = weighted_position + child_center_of_mass * child_mass;
         total_mass += child_mass;
@@ -71,6 +68,8 @@ Vector2d<double> QuadtreeNode::calculate_node_center_of_mass() {
         center_of_mass = Vector2d<double>(0.0, 0.0); // Falls keine Masse, setze den Standardwert
     }
 
+    cumulative_mass = total_mass;
+    cumulative_mass_ready = true;
     center_of_mass_ready = true;
     return center_of_mass;
 }
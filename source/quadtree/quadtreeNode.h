@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+#include <span>
 #include <vector>
 #include "structures/vector2d.h"
 #include "structures/bounding_box.h"
@@ -7,17 +10,61 @@
 
 class QuadtreeNode {
 public:
+    // Inline list of at most four children. Keeps a node free of heap
+    // allocations, so nodes can live in a QuadtreeNodeArena and be released
+    // without running destructors.
+    class ChildList {
+    public:
+        void push_back(QuadtreeNode* child) {
+            assert(count < 4 && "a quadtree node has at most four children");
+            nodes[count++] = child;
+        }
+        [[nodiscard]] std::size_t size() const {
+            return count;
+        }
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+        void clear() {
+            count = 0;
+        }
+        QuadtreeNode* operator[](std::size_t index) const {
+            return nodes[index];
+        }
+        QuadtreeNode* const* begin() const {
+            return nodes;
+        }
+        QuadtreeNode* const* end() const {
+            return nodes + count;
+        }
+
+    private:
+        QuadtreeNode* nodes[4] = {nullptr, nullptr, nullptr, nullptr};
+        std::uint8_t count = 0;
+    };
+
     QuadtreeNode(BoundingBox arg_bounding_box);
-    ~QuadtreeNode();
     double calculate_node_cumulative_mass();
     Vector2d<double> calculate_node_center_of_mass();
-    std::vector<QuadtreeNode*> children;
+    ChildList children;
     Vector2d<double> center_of_mass;
     double cumulative_mass;
+    // in-plane quadrupole Q_xx, Q_xy, Q_yy about the center of mass, set during
+    // construction; zero for single-body leaves
+    double quadrupole[3] = {0.0, 0.0, 0.0};
     std::int32_t body_identifier = -1;
+    // Bodies of a leaf, a contiguous range of the tree's index buffer. Holds a
+    // single body except for bucket leaves; empty for internal nodes.
+    std::span<const std::int32_t> bodies;
 
     bool center_of_mass_ready = false;
     bool cumulative_mass_ready = false;
 
+    // The node keeps its four bounds: the exercise tests pin the cells of this
+    // tree to halvings of the universe's rectangular bounding box and compare
+    // their bounds directly. Only the squared diagonal is precomputed, so the
+    // opening tests compare it against theta^2 * r^2 without touching the box.
+    // The compact center plus half width layout is used by LinearQuadtreeNode.
     BoundingBox bounding_box;
-};
\ No newline at end of file
+    double size_squared;
+};
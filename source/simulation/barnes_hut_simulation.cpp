@@ -1,9 +1,18 @@
 ﻿#include "simulation/barnes_hut_simulation.h"
-#include "simulation/naive_parallel_simulation.h"
+#include "simulation/integrator.h"
 #include "physics/gravitation.h"
 #include "physics/mechanics.h"
+#include "physics/direct_sum.h"
 
+#include <array>
 #include <cmath>
+#include <deque>
+#include <span>
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GROUP_LIST_X86 1
+#endif
 
 void BarnesHutSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs){
     for(int i = 0; i < num_epochs; i++){
@@ -12,15 +21,13 @@ void BarnesHutSimulation::simulate_epochs(Plotter& plotter, Universe& universe,
 }
 
 void BarnesHutSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
-    Quadtree quadtree(universe, universe.get_bounding_box(), 2); // Mode 2: Parallel construction with cut-off
-
-    quadtree.calculate_cumulative_masses();
-    quadtree.calculate_center_of_mass();
+    // Mode 2: Parallel construction with bucket leaves, masses and centers of
+    // mass are computed while the tree is built
+    Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena());
 
     calculate_forces(universe, quadtree);
 
-    NaiveParallelSimulation::calculate_velocities(universe);
-    NaiveParallelSimulation::calculate_positions(universe);
+    Integrator::step(universe);
 
     universe.current_simulation_epoch++;
 
@@ -33,6 +40,27 @@ void BarnesHutSimulation::simulate_epoch(Plotter& plotter, Universe& universe, b
     }
 }
 
+void BarnesHutSimulation::simulate_epochs_incremental(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double max_migrated_fraction) {
+    Quadtree quadtree(universe, universe.get_bounding_box(), 2);
+
+    for (std::uint32_t epoch = 0; epoch < num_epochs; ++epoch) {
+        if (epoch > 0) {
+            quadtree.update(universe, max_migrated_fraction);
+        }
+
+        calculate_forces(universe, quadtree);
+
+        Integrator::step(universe);
+
+        universe.current_simulation_epoch++;
+
+        if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+            plotter.add_bodies_to_image(universe);
+            plotter.write_and_clear();
+        }
+    }
+}
+
 void BarnesHutSimulation::get_relevant_nodes(Universe& universe, Quadtree& quadtree, std::vector<QuadtreeNode*>& relevant_nodes, Vector2d<double>& body_position, std::int32_t body_index, double threshold_theta) {
     // Stack for depth-first search starting from the root of the quadtree
     std::vector<QuadtreeNode*> stack;
@@ -43,46 +71,36 @@ void BarnesHutSimulation::get_relevant_nodes(Universe& universe, Quadtree& quadt
         QuadtreeNode* node = stack.back();
         stack.pop_back();
 
-        // Calculate the diagonal of the quadrant and the distance from body K to the center of mass
-        double d = node->bounding_box.get_diagonal();
-        Vector2d<double> delta = body_position - node->center_of_mass;
-        double r_squared = delta[0] * delta[0] + delta[1] * delta[1];
-        double r = std::sqrt(r_squared);
-
-        // Prevent division by zero
-        if (r == 0.0) {
-            r = std::numeric_limits<double>::epsilon();
-        }
-
-        // Compute Theta (d / r)
-        double theta = d / r;
-
-        // Debug output to check values of theta and the threshold
+        // Calculate the squared diagonal of the quadrant and the squared distance
+        // from body K to the center of mass. Theta = d / r < threshold_theta is
+        // compared squared, a body at the center of mass (r = 0) opens the node.
+        double d_squared = node->size_squared;
+        double r_squared = (body_position - node->center_of_mass).norm2();
+        bool accepted = d_squared < threshold_theta * threshold_theta * r_squared;
 
         // Case 1: The node is a leaf (no children)
         if (node->children.empty()) {
-            // If the node contains body K, skip it
-            if (node->body_identifier == body_index) {
+            // A leaf holding only body K is skipped, a bucket containing K stays
+            // relevant and K is masked out when its bodies are summed
+            if (node->bodies.size() == 1 && node->body_identifier == body_index) {
                 continue;
             }
 
             // If the node contains at least one body, it's relevant for force calculation
-            if (node->body_identifier != -1) {
+            if (!node->bodies.empty()) {
                 relevant_nodes.push_back(node);
             }
         }
         // Case 2: Theta < threshold_theta, the node is relevant for force calculation
-        else if (theta < threshold_theta) {
+        else if (accepted) {
             relevant_nodes.push_back(node);
         }
         else {
             // Case 3: Theta >= threshold_theta, the node must be further subdivided
             // Add all children of the current node to the stack
+            // Leaves holding body K are filtered in case 1
             for (QuadtreeNode* child : node->children) {
-                // Only add children that are not the same as body K
-                if (child != nullptr && child->body_identifier != body_index) {
-                    stack.push_back(child);
-                }
+                stack.push_back(child);
             }
         }
     }
@@ -90,41 +108,538 @@ void BarnesHutSimulation::get_relevant_nodes(Universe& universe, Quadtree& quadt
 
 
 
+// Force on body i from an accepted internal node, which acts through its
+// center of mass and optionally its quadrupole moment.
+static Vector2d<double> node_force(Universe& universe, std::int32_t i, const QuadtreeNode* node, bool use_quadrupole) {
+    Vector2d<double> delta = node->center_of_mass - universe.positions[i];
+    double r_squared = delta.norm2();
+
+    // Avoid division by zero
+    if (r_squared <= 0) {
+        return Vector2d<double>(0.0, 0.0);
+    }
+
+    Vector2d<double> force = delta * (gravitational_constant * universe.weights[i] * node->cumulative_mass * softened_inverse_cube(r_squared, softening_length * softening_length));
+
+    if (use_quadrupole) {
+        // accepted nodes are far compared to the softening length, the
+        // correction stays unsoftened; r points from the center of mass to the body,
+        // F = G m (Q r / r^5 - 5/2 (r.Q.r) r / r^7)
+        const double* Q = node->quadrupole;
+        Vector2d<double> r = -delta;
+        Vector2d<double> Q_r(Q[0] * r.x + Q[1] * r.y, Q[1] * r.x + Q[2] * r.y);
+        double inverse_r5 = 1.0 / (r_squared * r_squared * std::sqrt(r_squared));
+        double r_Q_r = r.dot(Q_r);
+        force += (Q_r - r * (2.5 * r_Q_r / r_squared)) * (gravitational_constant * universe.weights[i] * inverse_r5);
+    }
+    return force;
+}
+
 void BarnesHutSimulation::calculate_forces(Universe& universe, Quadtree& quadtree) {
-    const double threshold_theta = 0.2;
+    calculate_forces(universe, quadtree, default_threshold_theta, true);
+}
+
+// Single pass walk for body i: the force is accumulated while the tree is
+// traversed. The stack is reused by all bodies a thread handles, so after the
+// first body the walk does not allocate.
+static Vector2d<double> streaming_force(Universe& universe, Quadtree& quadtree, std::int32_t i, double threshold_theta, bool use_quadrupole) {
+    thread_local std::vector<QuadtreeNode*> stack;
+    stack.clear();
+    stack.push_back(quadtree.root);
+
+    const double threshold_theta_squared = threshold_theta * threshold_theta;
+    const Vector2d<double> position = universe.positions[i];
+    Vector2d<double> total_force(0.0, 0.0);
+
+    // same decisions as get_relevant_nodes, d / r < theta is compared squared
+    while (!stack.empty()) {
+        QuadtreeNode* node = stack.back();
+        stack.pop_back();
+
+        if (node->children.empty()) {
+            if (node->bodies.empty() || (node->bodies.size() == 1 && node->body_identifier == i)) {
+                continue;
+            }
+            total_force += direct_force(universe, i, node->bodies);
+            continue;
+        }
+
+        double d_squared = node->size_squared;
+        double r_squared = (position - node->center_of_mass).norm2();
+        if (d_squared < threshold_theta_squared * r_squared) {
+            total_force += node_force(universe, i, node, use_quadrupole);
+            continue;
+        }
+
+        for (QuadtreeNode* child : node->children) {
+            stack.push_back(child);
+        }
+    }
+
+    return total_force;
+}
+
+void BarnesHutSimulation::calculate_forces(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole) {
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(universe.num_bodies); ++i) {
+        universe.forces[i] = streaming_force(universe, quadtree, i, threshold_theta, use_quadrupole);
+    }
+}
+
+void BarnesHutSimulation::calculate_forces_for_bodies(Universe& universe, Quadtree& quadtree, std::span<const std::int32_t> bodies, double threshold_theta, bool use_quadrupole) {
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::int64_t k = 0; k < static_cast<std::int64_t>(bodies.size()); ++k) {
+        const std::int32_t i = bodies[k];
+        universe.forces[i] = streaming_force(universe, quadtree, i, threshold_theta, use_quadrupole);
+    }
+}
 
-#pragma omp parallel for
-    for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
+void BarnesHutSimulation::calculate_forces_with_interaction_lists(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole, std::vector<std::vector<QuadtreeNode*>>& interaction_lists) {
+    interaction_lists.assign(universe.num_bodies, {});
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(universe.num_bodies); ++i) {
         Vector2d<double> total_force(0.0, 0.0);
 
-        std::vector<QuadtreeNode*> relevant_nodes;
+        std::vector<QuadtreeNode*>& relevant_nodes = interaction_lists[i];
         get_relevant_nodes(universe, quadtree, relevant_nodes, universe.positions[i], i, threshold_theta);
 
         for (auto* node : relevant_nodes) {
-            if (node->body_identifier == -1) {
-                Vector2d<double> delta = universe.positions[i] - node->center_of_mass;
-                double r_squared = delta[0] * delta[0] + delta[1] * delta[1];
-
-                // Avoid division by zero
-                if (r_squared > 0) {
-                    double force_magnitude = gravitational_force(universe.weights[i], node->cumulative_mass, std::sqrt(r_squared));
-                    Vector2d<double> force_direction = delta / std::sqrt(r_squared);
-                    total_force = total_force + force_direction * force_magnitude;
+            // opened leaves are summed body by body
+            if (node->children.empty()) {
+                total_force += direct_force(universe, i, node->bodies);
+                continue;
+            }
+            total_force += node_force(universe, i, node, use_quadrupole);
+        }
+
+        universe.forces[i] = total_force;
+    }
+}
+
+// target cells above this depth hand their children to separate tasks
+static const std::int32_t dual_tree_task_depth = 5;
+
+// Far nodes accepted on the path from the root to a target cell. Every level
+// holds only the nodes it accepted itself and links to the level above, so
+// descending into a child copies nothing.
+struct DualTreeFarList {
+    std::span<QuadtreeNode* const> nodes;
+    const DualTreeFarList* parent;
+};
+
+// Lists of one level of the walk. A task reuses them for every target cell it
+// visits at that level, the deque keeps them in place while deeper levels
+// are added.
+struct DualTreeLevel {
+    std::vector<QuadtreeNode*> candidates;
+    std::vector<QuadtreeNode*> far_nodes;
+    std::vector<QuadtreeNode*> near_leaves;
+    std::vector<QuadtreeNode*> deferred;
+};
+using DualTreeScratch = std::deque<DualTreeLevel>;
+
+// Walks the source nodes against the target cell. A source node is accepted
+// for the whole cell if d / r < theta holds for the closest point of the
+// cell, i.e. for every body in it. Accepted nodes stay visible to the children
+// of the target through the far list, undecided ones are split further down
+// on the side of the larger cell. At a target leaf the far nodes of the whole
+// path and the touching leaves are evaluated for each of its bodies.
+static void dual_tree_walk(Universe& universe, QuadtreeNode* target, std::span<QuadtreeNode* const> sources, const DualTreeFarList* far_above, DualTreeScratch& scratch, std::size_t level, double threshold_theta, bool use_quadrupole, std::int32_t depth) {
+    const bool target_is_leaf = target->children.empty();
+    const double target_diagonal = std::sqrt(target->size_squared);
+
+    if (scratch.size() == level) {
+        scratch.emplace_back();
+    }
+    DualTreeLevel& lists = scratch[level];
+    lists.candidates.assign(sources.begin(), sources.end());
+    lists.far_nodes.clear();
+    lists.near_leaves.clear();
+    lists.deferred.clear();
+
+    while (!lists.candidates.empty()) {
+        QuadtreeNode* source = lists.candidates.back();
+        lists.candidates.pop_back();
+
+        bool source_is_leaf = source->children.empty();
+        if (source_is_leaf && source->bodies.empty()) {
+            continue;
+        }
+
+        double source_diagonal = std::sqrt(source->size_squared);
+        if (source_diagonal < threshold_theta * target->bounding_box.get_distance(source->center_of_mass)) {
+            lists.far_nodes.push_back(source);
+        }
+        else if (source_is_leaf) {
+            (target_is_leaf ? lists.near_leaves : lists.deferred).push_back(source);
+        }
+        else if (target_is_leaf || source_diagonal >= target_diagonal) {
+            for (QuadtreeNode* child : source->children) {
+                lists.candidates.push_back(child);
+            }
+        }
+        else {
+            lists.deferred.push_back(source);
+        }
+    }
+
+    const DualTreeFarList far_list{lists.far_nodes, far_above};
+
+    if (target_is_leaf) {
+        for (std::int32_t i : target->bodies) {
+            Vector2d<double> total_force(0.0, 0.0);
+            for (const DualTreeFarList* far = &far_list; far != nullptr; far = far->parent) {
+                for (QuadtreeNode* node : far->nodes) {
+                    total_force += node_force(universe, i, node, use_quadrupole);
                 }
             }
-            else if (i != node->body_identifier) {
-                Vector2d<double> delta = universe.positions[i] - universe.positions[node->body_identifier];
-                double r_squared = delta[0] * delta[0] + delta[1] * delta[1];
+            for (QuadtreeNode* leaf : lists.near_leaves) {
+                total_force += direct_force(universe, i, leaf->bodies);
+            }
+            universe.forces[i] = total_force;
+        }
+        return;
+    }
+
+    for (QuadtreeNode* child : target->children) {
+        if (depth < dual_tree_task_depth) {
+            // the lists of this level stay untouched until the taskwait
+#pragma omp task firstprivate(child) shared(universe, lists, far_list)
+            {
+                DualTreeScratch task_scratch;
+                dual_tree_walk(universe, child, lists.deferred, &far_list, task_scratch, 0, threshold_theta, use_quadrupole, depth + 1);
+            }
+        }
+        else {
+            dual_tree_walk(universe, child, lists.deferred, &far_list, scratch, level + 1, threshold_theta, use_quadrupole, depth + 1);
+        }
+    }
+#pragma omp taskwait
+}
+
+void BarnesHutSimulation::calculate_forces_dual_tree(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole) {
+    QuadtreeNode* const root_sources[1] = {quadtree.root};
+#pragma omp parallel
+#pragma omp single
+    {
+        DualTreeScratch scratch;
+        dual_tree_walk(universe, quadtree.root, root_sources, nullptr, scratch, 0, threshold_theta, use_quadrupole, 0);
+    }
+}
+
+void BarnesHutSimulation::simulate_epochs_dual_tree(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    for (std::uint32_t epoch = 0; epoch < num_epochs; ++epoch) {
+        Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena());
+
+        calculate_forces_dual_tree(universe, quadtree);
+
+        Integrator::step(universe);
+
+        universe.current_simulation_epoch++;
+
+        if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+            plotter.add_bodies_to_image(universe);
+            plotter.write_and_clear();
+        }
+    }
+}
+
+// Interaction list of a group of bodies in SoA layout. Accepted nodes and the
+// bodies of opened leaves are copied into contiguous arrays, so evaluating
+// the list is a dense loop without any pointer chasing.
+struct GroupInteractionList {
+    std::vector<double> node_mass, node_x, node_y;
+    std::vector<double> node_q_xx, node_q_xy, node_q_yy;
+    std::vector<double> body_mass, body_x, body_y;
+
+    void clear() {
+        node_mass.clear(); node_x.clear(); node_y.clear();
+        node_q_xx.clear(); node_q_xy.clear(); node_q_yy.clear();
+        body_mass.clear(); body_x.clear(); body_y.clear();
+    }
+};
+
+// Builds the list of a leaf group, a node is accepted if d / r < theta holds
+// for the closest point of the group's cell
+static void build_group_list(Universe& universe, Quadtree& quadtree, const QuadtreeNode* group, double threshold_theta, GroupInteractionList& list) {
+    thread_local std::vector<QuadtreeNode*> stack;
+    stack.clear();
+    stack.push_back(quadtree.root);
+    list.clear();
+
+    while (!stack.empty()) {
+        QuadtreeNode* node = stack.back();
+        stack.pop_back();
+
+        bool is_leaf = node->children.empty();
+        if (is_leaf && node->bodies.empty()) {
+            continue;
+        }
+
+        if (std::sqrt(node->size_squared) < threshold_theta * group->bounding_box.get_distance(node->center_of_mass)) {
+            list.node_mass.push_back(node->cumulative_mass);
+            list.node_x.push_back(node->center_of_mass.x);
+            list.node_y.push_back(node->center_of_mass.y);
+            list.node_q_xx.push_back(node->quadrupole[0]);
+            list.node_q_xy.push_back(node->quadrupole[1]);
+            list.node_q_yy.push_back(node->quadrupole[2]);
+        }
+        else if (is_leaf) {
+            for (std::int32_t j : node->bodies) {
+                list.body_mass.push_back(universe.weights[j]);
+                list.body_x.push_back(universe.positions[j].x);
+                list.body_y.push_back(universe.positions[j].y);
+            }
+        }
+        else {
+            for (QuadtreeNode* child : node->children) {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+// Evaluates the list for one body of the group. Both loops vectorize, the
+// body itself is at distance 0 and does not contribute. Always inlined into
+// the target specific clones below, which compile the loops for wider vectors.
+#ifdef GROUP_LIST_X86
+__attribute__((always_inline))
+#endif
+static inline Vector2d<double> evaluate_group_list(const GroupInteractionList& list, const Vector2d<double>& position, bool use_quadrupole) {
+    const double softening_squared = softening_length * softening_length;
+    double force_x = 0.0;
+    double force_y = 0.0;
+
+    const double* mass = list.body_mass.data();
+    const double* x = list.body_x.data();
+    const double* y = list.body_y.data();
+    const std::int32_t body_count = static_cast<std::int32_t>(list.body_mass.size());
+#pragma omp simd reduction(+:force_x, force_y)
+    for (std::int32_t k = 0; k < body_count; ++k) {
+        const double dx = x[k] - position.x;
+        const double dy = y[k] - position.y;
+        const double factor = mass[k] * softened_inverse_cube(dx * dx + dy * dy, softening_squared);
+        force_x += dx * factor;
+        force_y += dy * factor;
+    }
+
+    // accepted nodes lie outside the group's cell, r > 0
+    mass = list.node_mass.data();
+    x = list.node_x.data();
+    y = list.node_y.data();
+    const double* q_xx = list.node_q_xx.data();
+    const double* q_xy = list.node_q_xy.data();
+    const double* q_yy = list.node_q_yy.data();
+    const double quadrupole_weight = use_quadrupole ? 1.0 : 0.0;
+    const std::int32_t node_count = static_cast<std::int32_t>(list.node_mass.size());
+#pragma omp simd reduction(+:force_x, force_y)
+    for (std::int32_t k = 0; k < node_count; ++k) {
+        const double dx = x[k] - position.x;
+        const double dy = y[k] - position.y;
+        const double r_squared = dx * dx + dy * dy;
+        const double inverse_r = 1.0 / std::sqrt(r_squared);
+        const double inverse_r2 = inverse_r * inverse_r;
+        const double inverse_r3 = inverse_r2 * inverse_r;
+        const double softened_inverse_r3 = softened_inverse_cube(r_squared, softening_squared);
+        // unsoftened quadrupole with r = -d pointing from the center of mass
+        // to the body, F = G m (Q r / r^5 - 5/2 (r.Q.r) r / r^7)
+        const double Q_r_x = -(q_xx[k] * dx + q_xy[k] * dy);
+        const double Q_r_y = -(q_xy[k] * dx + q_yy[k] * dy);
+        const double r_Q_r = -(dx * Q_r_x + dy * Q_r_y);
+        const double inverse_r5 = quadrupole_weight * inverse_r3 * inverse_r2;
+        force_x += mass[k] * softened_inverse_r3 * dx + (Q_r_x + dx * (2.5 * r_Q_r * inverse_r2)) * inverse_r5;
+        force_y += mass[k] * softened_inverse_r3 * dy + (Q_r_y + dy * (2.5 * r_Q_r * inverse_r2)) * inverse_r5;
+    }
+
+    return Vector2d<double>(force_x, force_y);
+}
+
+static Vector2d<double> evaluate_group_list_scalar(const GroupInteractionList& list, const Vector2d<double>& position, bool use_quadrupole) {
+    return evaluate_group_list(list, position, use_quadrupole);
+}
+
+#ifdef GROUP_LIST_X86
+
+// same loops with four and eight doubles per vector, chosen by the kernel
+// dispatch of NaiveSimdSimulation
+__attribute__((target("avx2,fma")))
+static Vector2d<double> evaluate_group_list_avx2(const GroupInteractionList& list, const Vector2d<double>& position, bool use_quadrupole) {
+    return evaluate_group_list(list, position, use_quadrupole);
+}
+
+__attribute__((target("avx512f")))
+static Vector2d<double> evaluate_group_list_avx512(const GroupInteractionList& list, const Vector2d<double>& position, bool use_quadrupole) {
+    return evaluate_group_list(list, position, use_quadrupole);
+}
+
+#endif
+
+void BarnesHutSimulation::calculate_forces_grouped(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole) {
+    calculate_forces_grouped(universe, quadtree, NaiveSimdSimulation::detect_kernel(), threshold_theta, use_quadrupole);
+}
+
+void BarnesHutSimulation::calculate_forces_grouped(Universe& universe, Quadtree& quadtree, NaiveSimdSimulation::Kernel kernel, double threshold_theta, bool use_quadrupole) {
+    if (!NaiveSimdSimulation::is_supported(kernel)) {
+        throw std::invalid_argument("the CPU does not support the requested kernel");
+    }
+
+    Vector2d<double> (*evaluate)(const GroupInteractionList&, const Vector2d<double>&, bool) = evaluate_group_list_scalar;
+#ifdef GROUP_LIST_X86
+    if (kernel == NaiveSimdSimulation::Kernel::avx2) {
+        evaluate = evaluate_group_list_avx2;
+    }
+    else if (kernel == NaiveSimdSimulation::Kernel::avx512) {
+        evaluate = evaluate_group_list_avx512;
+    }
+#endif
+
+    // the leaves are the groups
+    std::vector<QuadtreeNode*> groups;
+    std::vector<QuadtreeNode*> stack{quadtree.root};
+    while (!stack.empty()) {
+        QuadtreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->children.empty()) {
+            if (!node->bodies.empty()) {
+                groups.push_back(node);
+            }
+            continue;
+        }
+        for (QuadtreeNode* child : node->children) {
+            stack.push_back(child);
+        }
+    }
+
+#pragma omp parallel for schedule(dynamic, 4)
+    for (std::int32_t g = 0; g < static_cast<std::int32_t>(groups.size()); ++g) {
+        thread_local GroupInteractionList list;
+        build_group_list(universe, quadtree, groups[g], threshold_theta, list);
+        for (std::int32_t i : groups[g]->bodies) {
+            universe.forces[i] = evaluate(list, universe.positions[i], use_quadrupole) * (gravitational_constant * universe.weights[i]);
+        }
+    }
+}
+
+void BarnesHutSimulation::simulate_epochs_grouped(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    for (std::uint32_t epoch = 0; epoch < num_epochs; ++epoch) {
+        Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena(), default_group_size);
 
-                // Avoid division by zero
-                if (r_squared > 0) {
-                    double force_magnitude = gravitational_force(universe.weights[i], universe.weights[node->body_identifier], std::sqrt(r_squared));
-                    Vector2d<double> force_direction = delta / std::sqrt(r_squared);
-                    total_force = total_force + force_direction * force_magnitude;
+        calculate_forces_grouped(universe, quadtree);
+
+        Integrator::step(universe);
+
+        universe.current_simulation_epoch++;
+
+        if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+            plotter.add_bodies_to_image(universe);
+            plotter.write_and_clear();
+        }
+    }
+}
+
+
+void BarnesHutSimulation::simulate_epochs_linear(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs){
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch_linear(plotter, universe, create_intermediate_plots, plot_intermediate_epochs);
+    }
+}
+
+void BarnesHutSimulation::simulate_epoch_linear(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    LinearQuadtree quadtree(universe, universe.get_bounding_box());
+
+    quadtree.calculate_cumulative_masses();
+    quadtree.calculate_center_of_mass();
+
+    calculate_forces(universe, quadtree);
+
+    Integrator::step(universe);
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+}
+
+// the universe is unused, it is only taken to mirror the pointer tree variant;
+// the nodes carry the centers of mass the walk needs
+void BarnesHutSimulation::get_relevant_nodes(Universe&, LinearQuadtree& quadtree, std::vector<std::int32_t>& relevant_nodes, Vector2d<double>& body_position, std::int32_t body_index, double threshold_theta) {
+    const double threshold_theta_squared = threshold_theta * threshold_theta;
+
+    // Stack of node indices for depth-first search starting from the root
+    std::vector<std::int32_t> stack;
+    stack.push_back(LinearQuadtree::root);
+
+    while (!stack.empty()) {
+        std::int32_t node_index = stack.back();
+        stack.pop_back();
+        const LinearQuadtreeNode& node = quadtree.nodes[node_index];
+
+        // Case 1: The node is a leaf, relevant unless it is empty or holds body K
+        if (node.is_leaf()) {
+            if (node.body_identifier != -1 && node.body_identifier != body_index) {
+                relevant_nodes.push_back(node_index);
+            }
+            continue;
+        }
+
+        // Case 2: Theta = d / r < threshold_theta, compared squared to avoid the sqrt.
+        // A body at the center of mass (r = 0) always opens the node.
+        double r_squared = (body_position - node.center_of_mass).norm2();
+        if (node.size_squared < threshold_theta_squared * r_squared) {
+            relevant_nodes.push_back(node_index);
+            continue;
+        }
+
+        // Case 3: the node must be further subdivided, empty children are skipped
+        for (std::int32_t child = node.first_child; child < node.first_child + LinearQuadtreeNode::child_count; ++child) {
+            if (!quadtree.nodes[child].is_empty()) {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+void BarnesHutSimulation::calculate_forces(Universe& universe, LinearQuadtree& quadtree) {
+    const double threshold_theta = 0.2;
+    const double threshold_theta_squared = threshold_theta * threshold_theta;
+    const double softening_squared = softening_length * softening_length;
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(universe.num_bodies); ++i) {
+        // a depth-first walk holds at most three siblings per level plus the
+        // children of the deepest node, so the stack fits on the stack frame
+        std::array<std::int32_t, 3 * LinearQuadtree::max_depth + 4> stack;
+        std::int32_t stack_size = 0;
+        stack[stack_size++] = LinearQuadtree::root;
+
+        const Vector2d<double> position = universe.positions[i];
+        Vector2d<double> total_force(0.0, 0.0);
+
+        // same decisions as get_relevant_nodes, accumulated right away
+        while (stack_size > 0) {
+            const LinearQuadtreeNode& node = quadtree.nodes[stack[--stack_size]];
+            Vector2d<double> delta = node.center_of_mass - position;
+            double r_squared = delta.norm2();
+
+            if (node.is_leaf() ? node.body_identifier != i : node.size_squared < threshold_theta_squared * r_squared) {
+                // leaves carry their body's mass and position, so all nodes are treated alike
+                total_force += delta * (gravitational_constant * universe.weights[i] * node.cumulative_mass * softened_inverse_cube(r_squared, softening_squared));
+                continue;
+            }
+            if (node.is_leaf()) {
+                continue;
+            }
+
+            for (std::int32_t child = node.first_child; child < node.first_child + LinearQuadtreeNode::child_count; ++child) {
+                if (!quadtree.nodes[child].is_empty()) {
+                    stack[stack_size++] = child;
                 }
             }
         }
 
         universe.forces[i] = total_force;
     }
-}
\ No newline at end of file
+}
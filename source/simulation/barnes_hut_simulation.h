@@ -3,12 +3,49 @@
 
 #include "structures/universe.h"
 #include "quadtree/quadtree.h"
+#include "quadtree/linear_quadtree.h"
 #include "plotting/plotter.h"
+#include "simulation/naive_simd_simulation.h"
 
 class BarnesHutSimulation{
 public:
+    // With quadrupole moments theta 0.3 is at least as accurate as the
+    // monopole alone at theta 0.2 and opens fewer nodes
+    static constexpr double default_threshold_theta = 0.3;
+
     static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
     static void simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
     static void calculate_forces(Universe& universe, Quadtree& quadtree);
+    // far field of accepted nodes as monopole, or monopole plus quadrupole
+    static void calculate_forces(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole);
+    // forces on the listed bodies only, the others keep theirs
+    static void calculate_forces_for_bodies(Universe& universe, Quadtree& quadtree, std::span<const std::int32_t> bodies, double threshold_theta = default_threshold_theta, bool use_quadrupole = true);
+    // debug variant: collects the relevant nodes of every body with
+    // get_relevant_nodes first and exports them next to the forces
+    static void calculate_forces_with_interaction_lists(Universe& universe, Quadtree& quadtree, double threshold_theta, bool use_quadrupole, std::vector<std::vector<QuadtreeNode*>>& interaction_lists);
     static void get_relevant_nodes(Universe& universe, Quadtree& quadtree, std::vector<QuadtreeNode*>& relevant_nodes, Vector2d<double>& body_position, std::int32_t body_index, double threshold_theta);
+
+    // cell-cell traversal: the bodies of a leaf share one walk, a node is
+    // accepted for all of them at once when it is far enough from the whole cell
+    static void calculate_forces_dual_tree(Universe& universe, Quadtree& quadtree, double threshold_theta = default_threshold_theta, bool use_quadrupole = true);
+    static void simulate_epochs_dual_tree(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+
+    // Leaves of about default_group_size bodies share one interaction list in
+    // SoA layout: accepted nodes and the bodies of opened leaves, evaluated for
+    // every body of the leaf by vectorized loops. The loops are compiled for
+    // each kernel of NaiveSimdSimulation, the widest one the CPU supports is used
+    static constexpr std::int32_t default_group_size = 32;
+    static void calculate_forces_grouped(Universe& universe, Quadtree& quadtree, double threshold_theta = default_threshold_theta, bool use_quadrupole = true);
+    static void calculate_forces_grouped(Universe& universe, Quadtree& quadtree, NaiveSimdSimulation::Kernel kernel, double threshold_theta = default_threshold_theta, bool use_quadrupole = true);
+    static void simulate_epochs_grouped(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+
+    // keeps one tree over all epochs and updates it with Quadtree::update
+    // instead of rebuilding it, for slowly evolving systems
+    static void simulate_epochs_incremental(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double max_migrated_fraction = Quadtree::default_max_migrated_fraction);
+
+    // same scheme on the pointerless LinearQuadtree, nodes are referenced by index
+    static void simulate_epochs_linear(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    static void simulate_epoch_linear(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    static void calculate_forces(Universe& universe, LinearQuadtree& quadtree);
+    static void get_relevant_nodes(Universe& universe, LinearQuadtree& quadtree, std::vector<std::int32_t>& relevant_nodes, Vector2d<double>& body_position, std::int32_t body_index, double threshold_theta);
 };
\ No newline at end of file
@@ -27,7 +27,7 @@ void BarnesHutSimulationWithCollisions::find_collisions(Universe& universe) {
         for (std::size_t j = i + 1; j < universe.num_bodies; ++j) {
             // Compute the squared distance between the two bodies
             Vector2d<double> delta = universe.positions[i] - universe.positions[j];
-            double distance_squared = delta[0] * delta[0] + delta[1] * delta[1];
+            double distance_squared = delta.norm2();
 
             // Check if the squared distance is below the collision threshold
             if (distance_squared < collision_distance_squared) {
@@ -89,7 +89,7 @@ void BarnesHutSimulationWithCollisions::find_collisions_parallel(Universe& unive
             for (std::size_t j = i + 1; j < universe.num_bodies; ++j) {
                 // Compute the squared distance between the two bodies
                 Vector2d<double> delta = universe.positions[i] - universe.positions[j];
-                double distance_squared = delta[0] * delta[0] + delta[1] * delta[1];
+                double distance_squared = delta.norm2();
 
                 // If the distance between bodies is smaller than the collision threshold
                 if (distance_squared < collision_distance_squared) {
@@ -0,0 +1,122 @@
+#include "simulation/block_timestep_simulation.h"
+#include "simulation/barnes_hut_simulation.h"
+#include "simulation/constants.h"
+#include "physics/gravitation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+void BlockTimestepSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t max_rung, double accuracy){
+    // the first epoch needs the forces at the initial positions
+    {
+        Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena());
+        BarnesHutSimulation::calculate_forces(universe, quadtree);
+    }
+
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs, max_rung, accuracy);
+    }
+}
+
+std::int32_t BlockTimestepSimulation::calculate_rung(double acceleration, double length_scale, double accuracy, std::int32_t max_rung){
+    // halve the step while dt^2 |a| > accuracy^2 * length_scale
+    std::int32_t rung = 0;
+    double step = epoch_in_seconds;
+    while (rung < max_rung && step * step * acceleration > accuracy * accuracy * length_scale) {
+        step *= 0.5;
+        ++rung;
+    }
+    return rung;
+}
+
+static double timestep_length_scale(Universe& universe) {
+    if (softening_length > 0.0) {
+        return softening_length;
+    }
+    BoundingBox bb = universe.get_bounding_box();
+    double extent = std::max(bb.x_max - bb.x_min, bb.y_max - bb.y_min);
+    return extent / std::sqrt(static_cast<double>(std::max(universe.num_bodies, 1u)));
+}
+
+std::uint64_t BlockTimestepSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t max_rung, double accuracy){
+    const std::int64_t num_bodies = universe.num_bodies;
+    // time is counted in ticks of the deepest rung, a step of rung r is total_ticks >> r ticks long
+    const std::int64_t total_ticks = std::int64_t{1} << max_rung;
+    const double tick = epoch_in_seconds / static_cast<double>(total_ticks);
+    const double length_scale = timestep_length_scale(universe);
+
+    std::vector<std::int32_t> rungs(num_bodies);
+    std::vector<std::int64_t> step_ends(num_bodies);
+
+    // every body opens a step at the start of the epoch
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        const double acceleration = std::sqrt(universe.forces[i].norm2()) / universe.weights[i];
+        rungs[i] = calculate_rung(acceleration, length_scale, accuracy, max_rung);
+        step_ends[i] = total_ticks >> rungs[i];
+        universe.velocities[i] += universe.forces[i] * (0.5 * static_cast<double>(step_ends[i]) * tick / universe.weights[i]);
+    }
+
+    Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena());
+    std::vector<std::int32_t> active;
+    std::uint64_t force_evaluations = 0;
+
+    std::int64_t now = 0;
+    while (now < total_ticks) {
+        std::int64_t next = total_ticks;
+#pragma omp parallel for reduction(min:next) schedule(static)
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            next = std::min(next, step_ends[i]);
+        }
+
+        // all bodies drift to the next step end
+        const double drift = static_cast<double>(next - now) * tick;
+#pragma omp parallel for schedule(static)
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            universe.positions[i] += universe.velocities[i] * drift;
+        }
+        now = next;
+
+        active.clear();
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            if (step_ends[i] == now) {
+                active.push_back(static_cast<std::int32_t>(i));
+            }
+        }
+
+        quadtree.update(universe);
+        BarnesHutSimulation::calculate_forces_for_bodies(universe, quadtree, active);
+        force_evaluations += active.size();
+
+        // The closing half kick of the finished step and the opening half kick
+        // of the next one use the same force and are applied together. A step
+        // has to start at a multiple of its own length, so a body can only
+        // move to a shallower rung where the steps of that rung line up.
+#pragma omp parallel for schedule(static)
+        for (std::int64_t k = 0; k < static_cast<std::int64_t>(active.size()); ++k) {
+            const std::int32_t i = active[k];
+            double kick_ticks = 0.5 * static_cast<double>(total_ticks >> rungs[i]);
+            if (now < total_ticks) {
+                const double acceleration = std::sqrt(universe.forces[i].norm2()) / universe.weights[i];
+                std::int32_t rung = calculate_rung(acceleration, length_scale, accuracy, max_rung);
+                while (now % (total_ticks >> rung) != 0) {
+                    ++rung;
+                }
+                rungs[i] = rung;
+                step_ends[i] = now + (total_ticks >> rung);
+                kick_ticks += 0.5 * static_cast<double>(total_ticks >> rung);
+            }
+            universe.velocities[i] += universe.forces[i] * (kick_ticks * tick / universe.weights[i]);
+        }
+    }
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+
+    return force_evaluations;
+}
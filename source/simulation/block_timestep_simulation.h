@@ -0,0 +1,28 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "plotting/plotter.h"
+
+// Barnes-Hut with hierarchical block timesteps. A body on rung r advances in
+// steps of epoch_in_seconds / 2^r, the rung follows from its acceleration. An
+// epoch is walked from step end to step end; at each of them all bodies drift,
+// the tree is refitted with Quadtree::update and forces are computed only for
+// the bodies whose step ends there. Steps are kick-drift-kick leapfrog steps,
+// at the end of an epoch all rungs are synchronized again.
+class BlockTimestepSimulation{
+public:
+    static constexpr std::int32_t default_max_rung = 8;
+    // dt <= accuracy * sqrt(length_scale / |a|)
+    static constexpr double default_accuracy = 0.05;
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t max_rung = default_max_rung, double accuracy = default_accuracy);
+    // universe.forces must hold the forces at the current positions and do so
+    // again afterwards. Returns the number of force evaluations of single bodies.
+    static std::uint64_t simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t max_rung = default_max_rung, double accuracy = default_accuracy);
+
+    // Shallowest rung whose step meets the accuracy criterion, at most max_rung.
+    // The length scale is the softening length, or the mean distance of the
+    // bodies without softening.
+    static std::int32_t calculate_rung(double acceleration, double length_scale, double accuracy, std::int32_t max_rung);
+};
@@ -1,4 +1,4 @@
 #pragma once
 
-// time of one epoch -> 1 Month = 2,628e+6s
-static const double epoch_in_seconds = 2.628e+6;
\ No newline at end of file
+// time of one epoch -> 1 Month = 2,628e+6s, set once before a simulation starts
+inline double epoch_in_seconds = 2.628e+6;
@@ -0,0 +1,353 @@
+#include "simulation/fmm_simulation.h"
+#include "simulation/integrator.h"
+#include "physics/gravitation.h"
+#include "physics/direct_sum.h"
+
+#include <cmath>
+#include <span>
+#include <vector>
+
+void FmmSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t order){
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs, order);
+    }
+}
+
+void FmmSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t order){
+    Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena(), default_leaf_capacity);
+
+    calculate_forces(universe, quadtree, order);
+
+    Integrator::step(universe);
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+}
+
+// Cell of the flattened tree. Cells are stored level by level, the children of
+// a cell are contiguous. The expansion center is the center of the box and the
+// radius bounds the distance of every body of the cell from it.
+struct FmmCell {
+    QuadtreeNode* node = nullptr;
+    Vector2d<double> center;
+    double radius = 0.0;
+    std::int32_t first_child = -1;
+    std::int32_t child_count = 0;
+    std::int32_t level = 0;
+};
+
+// Expansion coefficients of a cell are indexed by the multi-index (a, b) with
+// a + b <= order, sorted by degree: index(a, b) = n (n + 1) / 2 + b, n = a + b.
+//   multipole M_(a,b) = sum_k m_k v_x^a v_y^b / (a! b!),  v = x_k - center
+//   local     Phi(center + u) = sum L_(a,b) u_x^a u_y^b / (a! b!)
+// where Phi(x) = sum_k m_k / |x - x_k|.
+struct FmmTree {
+    std::vector<FmmCell> cells;
+    std::vector<std::int32_t> level_offsets;
+    std::int32_t order = 0;
+    std::int32_t coefficients = 0;
+    std::vector<double> multipoles;
+    std::vector<double> locals;
+    // 1 / n! for n <= 2 * order
+    std::vector<double> inverse_factorials;
+
+    [[nodiscard]] static std::int32_t index(std::int32_t a, std::int32_t b) {
+        std::int32_t n = a + b;
+        return n * (n + 1) / 2 + b;
+    }
+    double* multipole(std::int32_t cell) {
+        return multipoles.data() + static_cast<std::size_t>(cell) * coefficients;
+    }
+    double* local(std::int32_t cell) {
+        return locals.data() + static_cast<std::size_t>(cell) * coefficients;
+    }
+};
+
+// subtrees of target cells above this level are walked as separate tasks
+static const std::int32_t fmm_task_level = 6;
+
+static void flatten(FmmTree& tree, Quadtree& quadtree) {
+    auto make_cell = [](QuadtreeNode* node, std::int32_t level) {
+        FmmCell cell;
+        cell.node = node;
+        const BoundingBox& BB = node->bounding_box;
+        cell.center = Vector2d<double>((BB.x_min + BB.x_max) / 2.0, (BB.y_min + BB.y_max) / 2.0);
+        cell.radius = 0.5 * std::sqrt(node->size_squared);
+        cell.level = level;
+        return cell;
+    };
+
+    tree.cells.clear();
+    tree.level_offsets.clear();
+    tree.cells.push_back(make_cell(quadtree.root, 0));
+    tree.level_offsets.push_back(0);
+
+    // breadth-first, like LinearQuadtree
+    std::int32_t level_end = 1;
+    std::int32_t level = 0;
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(tree.cells.size()); ++i) {
+        if (i == level_end) {
+            tree.level_offsets.push_back(i);
+            level_end = static_cast<std::int32_t>(tree.cells.size());
+            level++;
+        }
+        QuadtreeNode* node = tree.cells[i].node;
+        if (node->children.empty()) {
+            continue;
+        }
+        tree.cells[i].first_child = static_cast<std::int32_t>(tree.cells.size());
+        tree.cells[i].child_count = static_cast<std::int32_t>(node->children.size());
+        for (QuadtreeNode* child : node->children) {
+            tree.cells.push_back(make_cell(child, level + 1));
+        }
+    }
+    tree.level_offsets.push_back(static_cast<std::int32_t>(tree.cells.size()));
+}
+
+// scaled powers d_x^a / a! and d_y^b / b! for a, b <= order
+static void scaled_powers(const FmmTree& tree, const Vector2d<double>& d, double* powers_x, double* powers_y) {
+    powers_x[0] = 1.0;
+    powers_y[0] = 1.0;
+    for (std::int32_t n = 1; n <= tree.order; ++n) {
+        powers_x[n] = powers_x[n - 1] * d.x / n;
+        powers_y[n] = powers_y[n - 1] * d.y / n;
+    }
+}
+
+static void p2m(FmmTree& tree, Universe& universe, std::int32_t cell) {
+    double* M = tree.multipole(cell);
+    std::vector<double> powers_x(tree.order + 1);
+    std::vector<double> powers_y(tree.order + 1);
+    for (std::int32_t body : tree.cells[cell].node->bodies) {
+        scaled_powers(tree, universe.positions[body] - tree.cells[cell].center, powers_x.data(), powers_y.data());
+        double mass = universe.weights[body];
+        for (std::int32_t n = 0; n <= tree.order; ++n) {
+            for (std::int32_t b = 0; b <= n; ++b) {
+                M[FmmTree::index(n - b, b)] += mass * powers_x[n - b] * powers_y[b];
+            }
+        }
+    }
+}
+
+// shifts the multipoles of the children to the center of the cell
+static void m2m(FmmTree& tree, std::int32_t cell) {
+    double* M = tree.multipole(cell);
+    std::vector<double> powers_x(tree.order + 1);
+    std::vector<double> powers_y(tree.order + 1);
+    const FmmCell& parent = tree.cells[cell];
+    for (std::int32_t child = parent.first_child; child < parent.first_child + parent.child_count; ++child) {
+        const double* M_child = tree.multipole(child);
+        scaled_powers(tree, tree.cells[child].center - parent.center, powers_x.data(), powers_y.data());
+        // M_(a,b) += sum_(i<=a, j<=b) d^(a-i,b-j) / (a-i)!(b-j)! M_child_(i,j)
+        for (std::int32_t n = 0; n <= tree.order; ++n) {
+            for (std::int32_t b = 0; b <= n; ++b) {
+                std::int32_t a = n - b;
+                double sum = 0.0;
+                for (std::int32_t i = 0; i <= a; ++i) {
+                    for (std::int32_t j = 0; j <= b; ++j) {
+                        sum += powers_x[a - i] * powers_y[b - j] * M_child[FmmTree::index(i, j)];
+                    }
+                }
+                M[FmmTree::index(a, b)] += sum;
+            }
+        }
+    }
+}
+
+// Derivatives D_(a,b) = d^a/dx^a d^b/dy^b 1/|R| for a + b <= order. The Taylor
+// coefficients t = (-1)^n D / (a! b!) of 1/|R| satisfy
+//   n |R|^2 t_k = (2n - 1) sum_i R_i t_(k - e_i) - (n - 1) sum_i t_(k - 2 e_i)
+static void derivatives(const FmmTree& tree, const Vector2d<double>& R, double* D) {
+    double r_squared = R.norm2();
+    D[0] = 1.0 / std::sqrt(r_squared);
+    for (std::int32_t n = 1; n <= tree.order; ++n) {
+        for (std::int32_t b = 0; b <= n; ++b) {
+            std::int32_t a = n - b;
+            double value = 0.0;
+            if (a >= 1) value += (2 * n - 1) * R.x * D[FmmTree::index(a - 1, b)];
+            if (b >= 1) value += (2 * n - 1) * R.y * D[FmmTree::index(a, b - 1)];
+            if (a >= 2) value -= (n - 1) * D[FmmTree::index(a - 2, b)];
+            if (b >= 2) value -= (n - 1) * D[FmmTree::index(a, b - 2)];
+            D[FmmTree::index(a, b)] = value / (n * r_squared);
+        }
+    }
+    // from Taylor coefficients to derivatives
+    for (std::int32_t n = 1; n <= tree.order; ++n) {
+        double sign = (n % 2 == 0) ? 1.0 : -1.0;
+        for (std::int32_t b = 0; b <= n; ++b) {
+            std::int32_t a = n - b;
+            D[FmmTree::index(a, b)] *= sign / (tree.inverse_factorials[a] * tree.inverse_factorials[b]);
+        }
+    }
+}
+
+// local expansion of the target cell from the multipole of the source cell,
+//   L_j += sum_k (-1)^|k| M_k D_(j+k)(c_target - c_source)
+static void m2l(FmmTree& tree, std::int32_t target, std::int32_t source, double* D) {
+    derivatives(tree, tree.cells[target].center - tree.cells[source].center, D);
+    double* L = tree.local(target);
+    const double* M = tree.multipole(source);
+    for (std::int32_t n = 0; n <= tree.order; ++n) {
+        for (std::int32_t b = 0; b <= n; ++b) {
+            std::int32_t a = n - b;
+            double sum = 0.0;
+            for (std::int32_t m = 0; m <= tree.order - n; ++m) {
+                double sign = (m % 2 == 0) ? 1.0 : -1.0;
+                for (std::int32_t j = 0; j <= m; ++j) {
+                    sum += sign * M[FmmTree::index(m - j, j)] * D[FmmTree::index(a + m - j, b + j)];
+                }
+            }
+            L[FmmTree::index(a, b)] += sum;
+        }
+    }
+}
+
+// shifts the local expansion of the cell to the centers of its children
+static void l2l(FmmTree& tree, std::int32_t cell) {
+    const double* L = tree.local(cell);
+    std::vector<double> powers_x(tree.order + 1);
+    std::vector<double> powers_y(tree.order + 1);
+    const FmmCell& parent = tree.cells[cell];
+    for (std::int32_t child = parent.first_child; child < parent.first_child + parent.child_count; ++child) {
+        double* L_child = tree.local(child);
+        scaled_powers(tree, tree.cells[child].center - parent.center, powers_x.data(), powers_y.data());
+        // L_child_(a,b) += sum_(i,j) L_(a+i,b+j) d^(i,j) / i! j!
+        for (std::int32_t n = 0; n <= tree.order; ++n) {
+            for (std::int32_t b = 0; b <= n; ++b) {
+                std::int32_t a = n - b;
+                double sum = 0.0;
+                for (std::int32_t m = 0; m <= tree.order - n; ++m) {
+                    for (std::int32_t j = 0; j <= m; ++j) {
+                        sum += L[FmmTree::index(a + m - j, b + j)] * powers_x[m - j] * powers_y[j];
+                    }
+                }
+                L_child[FmmTree::index(a, b)] += sum;
+            }
+        }
+    }
+}
+
+// far field force on the bodies of a leaf, F = G m grad Phi
+static void l2p(FmmTree& tree, Universe& universe, std::int32_t cell) {
+    const double* L = tree.local(cell);
+    std::vector<double> powers_x(tree.order + 1);
+    std::vector<double> powers_y(tree.order + 1);
+    for (std::int32_t body : tree.cells[cell].node->bodies) {
+        scaled_powers(tree, universe.positions[body] - tree.cells[cell].center, powers_x.data(), powers_y.data());
+        Vector2d<double> gradient(0.0, 0.0);
+        for (std::int32_t n = 0; n < tree.order; ++n) {
+            for (std::int32_t b = 0; b <= n; ++b) {
+                std::int32_t a = n - b;
+                double power = powers_x[a] * powers_y[b];
+                gradient.x += L[FmmTree::index(a + 1, b)] * power;
+                gradient.y += L[FmmTree::index(a, b + 1)] * power;
+            }
+        }
+        universe.forces[body] += gradient * (gravitational_constant * universe.weights[body]);
+    }
+}
+
+// Direct softened forces of the source bodies on the target bodies, a body at
+// distance 0 (the target itself) does not contribute. Well separated cells are
+// far apart compared to the softening length, the expansions stay unsoftened.
+static void p2p(Universe& universe, std::span<const std::int32_t> targets, std::span<const std::int32_t> sources) {
+    for (std::int32_t i : targets) {
+        universe.forces[i] += direct_force(universe, i, sources);
+    }
+}
+
+// Dual-tree walk, only the target side is written. Splitting the target hands
+// its children to separate tasks, which own disjoint subtrees; the walk waits
+// for them before it touches the target again.
+static void interact(FmmTree& tree, Universe& universe, std::int32_t target, std::int32_t source, double threshold_theta, std::vector<double>& D) {
+    const FmmCell& A = tree.cells[target];
+    const FmmCell& B = tree.cells[source];
+
+    double distance = std::sqrt((A.center - B.center).norm2());
+    if (A.radius + B.radius < threshold_theta * distance) {
+        m2l(tree, target, source, D.data());
+        return;
+    }
+
+    bool target_is_leaf = A.child_count == 0;
+    bool source_is_leaf = B.child_count == 0;
+    if (target_is_leaf && source_is_leaf) {
+        p2p(universe, A.node->bodies, B.node->bodies);
+        return;
+    }
+
+    if (!target_is_leaf && (source_is_leaf || A.radius >= B.radius)) {
+        for (std::int32_t child = A.first_child; child < A.first_child + A.child_count; ++child) {
+#pragma omp task if(A.level < fmm_task_level) firstprivate(child) shared(tree, universe)
+            {
+                std::vector<double> task_D(tree.coefficients);
+                interact(tree, universe, child, source, threshold_theta, task_D);
+            }
+        }
+#pragma omp taskwait
+    }
+    else {
+        for (std::int32_t child = B.first_child; child < B.first_child + B.child_count; ++child) {
+            interact(tree, universe, target, child, threshold_theta, D);
+        }
+    }
+}
+
+void FmmSimulation::calculate_forces(Universe& universe, Quadtree& quadtree, std::int32_t order, double threshold_theta) {
+    FmmTree tree;
+    tree.order = order;
+    tree.coefficients = (order + 1) * (order + 2) / 2;
+    tree.inverse_factorials.assign(2 * order + 2, 1.0);
+    for (std::int32_t n = 1; n < static_cast<std::int32_t>(tree.inverse_factorials.size()); ++n) {
+        tree.inverse_factorials[n] = tree.inverse_factorials[n - 1] / n;
+    }
+
+    flatten(tree, quadtree);
+    const std::int32_t num_cells = static_cast<std::int32_t>(tree.cells.size());
+    const std::int32_t num_levels = static_cast<std::int32_t>(tree.level_offsets.size()) - 1;
+    tree.multipoles.assign(static_cast<std::size_t>(num_cells) * tree.coefficients, 0.0);
+    tree.locals.assign(static_cast<std::size_t>(num_cells) * tree.coefficients, 0.0);
+
+#pragma omp parallel for
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(universe.num_bodies); ++i) {
+        universe.forces[i] = Vector2d<double>(0.0, 0.0);
+    }
+
+    // upward pass: P2M at the leaves, M2M level by level from the bottom
+    for (std::int32_t level = num_levels - 1; level >= 0; --level) {
+#pragma omp parallel for schedule(dynamic, 16)
+        for (std::int32_t cell = tree.level_offsets[level]; cell < tree.level_offsets[level + 1]; ++cell) {
+            if (tree.cells[cell].child_count == 0) {
+                p2m(tree, universe, cell);
+            }
+            else {
+                m2m(tree, cell);
+            }
+        }
+    }
+
+    // M2L and P2P
+#pragma omp parallel
+#pragma omp single
+    {
+        std::vector<double> D(tree.coefficients);
+        interact(tree, universe, 0, 0, threshold_theta, D);
+    }
+
+    // downward pass: L2L level by level from the top, L2P at the leaves
+    for (std::int32_t level = 0; level < num_levels; ++level) {
+#pragma omp parallel for schedule(dynamic, 16)
+        for (std::int32_t cell = tree.level_offsets[level]; cell < tree.level_offsets[level + 1]; ++cell) {
+            if (tree.cells[cell].child_count == 0) {
+                l2p(tree, universe, cell);
+            }
+            else {
+                l2l(tree, cell);
+            }
+        }
+    }
+}
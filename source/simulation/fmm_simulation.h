@@ -0,0 +1,24 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "quadtree/quadtree.h"
+#include "plotting/plotter.h"
+
+// Fast multipole method on the bucket quadtree of Barnes-Hut. Cells carry
+// Cartesian Taylor expansions of the 1/r potential up to a configurable order.
+// Multipoles are formed bottom-up (P2M, M2M), a dual-tree walk turns every
+// pair of well separated cells into one M2L and every pair of touching leaves
+// into direct sums (P2P), and the local expansions are pushed down to the
+// bodies (L2L, L2P). The work is linear in the number of bodies.
+class FmmSimulation{
+public:
+    static constexpr std::int32_t default_order = 6;
+    // cells A and B interact through expansions if r_A + r_B < theta * |c_A - c_B|
+    static constexpr double default_threshold_theta = 0.5;
+    static constexpr std::int32_t default_leaf_capacity = 32;
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t order = default_order);
+    static void simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t order = default_order);
+    static void calculate_forces(Universe& universe, Quadtree& quadtree, std::int32_t order = default_order, double threshold_theta = default_threshold_theta);
+};
@@ -0,0 +1,181 @@
+#include "simulation/hermite_simulation.h"
+#include "simulation/constants.h"
+#include "physics/gravitation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+static const std::int64_t total_ticks = std::int64_t{1} << HermiteSimulation::max_level;
+
+void HermiteSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double accuracy){
+    State state;
+    initialize(universe, state);
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch(plotter, universe, state, create_intermediate_plots, plot_intermediate_epochs, accuracy);
+    }
+}
+
+void HermiteSimulation::calculate_accelerations_and_jerks(const Universe& universe, const std::vector<Vector2d<double>>& positions, const std::vector<Vector2d<double>>& velocities, const std::vector<std::int32_t>& targets, std::vector<Vector2d<double>>& accelerations, std::vector<Vector2d<double>>& jerks) {
+    const std::int64_t num_bodies = universe.num_bodies;
+    const Vector2d<double>* x = positions.data();
+    const Vector2d<double>* v = velocities.data();
+    const double* weights = universe.weights.data();
+    const double softening_squared = softening_length * softening_length;
+
+    // a_i = G sum m_j r / |r|^3,  j_i = G sum m_j (w / |r|^3 - 3 (r.w) r / |r|^5)
+    // with r = x_j - x_i, w = v_j - v_i; body i itself has r = 0 and drops out
+#pragma omp parallel for schedule(dynamic, 16)
+    for (std::int64_t k = 0; k < static_cast<std::int64_t>(targets.size()); ++k) {
+        const std::int32_t i = targets[k];
+        const Vector2d<double> position = x[i];
+        const Vector2d<double> velocity = v[i];
+
+        double acceleration_x = 0.0;
+        double acceleration_y = 0.0;
+        double jerk_x = 0.0;
+        double jerk_y = 0.0;
+#pragma omp simd reduction(+:acceleration_x, acceleration_y, jerk_x, jerk_y)
+        for (std::int64_t j = 0; j < num_bodies; ++j) {
+            const double dx = x[j].x - position.x;
+            const double dy = x[j].y - position.y;
+            const double dvx = v[j].x - velocity.x;
+            const double dvy = v[j].y - velocity.y;
+            const double r_squared = dx * dx + dy * dy;
+            const double softened = r_squared + softening_squared;
+            const double mass_inverse_cube = weights[j] * softened_inverse_cube(r_squared, softening_squared);
+            const double projection = softened > 0.0 ? 3.0 * (dx * dvx + dy * dvy) / softened : 0.0;
+            acceleration_x += dx * mass_inverse_cube;
+            acceleration_y += dy * mass_inverse_cube;
+            jerk_x += (dvx - projection * dx) * mass_inverse_cube;
+            jerk_y += (dvy - projection * dy) * mass_inverse_cube;
+        }
+
+        accelerations[i] = Vector2d<double>(acceleration_x, acceleration_y) * gravitational_constant;
+        jerks[i] = Vector2d<double>(jerk_x, jerk_y) * gravitational_constant;
+    }
+}
+
+// largest power of two number of ticks not above the step, at least one tick
+static std::int64_t quantize_step(double step_in_seconds, double tick) {
+    std::int64_t ticks = total_ticks;
+    while (ticks > 1 && static_cast<double>(ticks) * tick > step_in_seconds) {
+        ticks >>= 1;
+    }
+    return ticks;
+}
+
+void HermiteSimulation::initialize(Universe& universe, State& state) {
+    const std::int64_t num_bodies = universe.num_bodies;
+    state.accelerations.assign(num_bodies, Vector2d<double>(0.0, 0.0));
+    state.jerks.assign(num_bodies, Vector2d<double>(0.0, 0.0));
+    state.steps.assign(num_bodies, total_ticks);
+
+    std::vector<std::int32_t> everybody(num_bodies);
+    std::iota(everybody.begin(), everybody.end(), 0);
+    calculate_accelerations_and_jerks(universe, universe.positions, universe.velocities, everybody, state.accelerations, state.jerks);
+
+    const double tick = epoch_in_seconds / static_cast<double>(total_ticks);
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        const double acceleration = std::sqrt(state.accelerations[i].norm2());
+        const double jerk = std::sqrt(state.jerks[i].norm2());
+        state.steps[i] = jerk > 0.0 ? quantize_step(default_initial_accuracy * acceleration / jerk, tick) : total_ticks;
+        universe.forces[i] = state.accelerations[i] * universe.weights[i];
+    }
+}
+
+std::uint64_t HermiteSimulation::simulate_epoch(Plotter& plotter, Universe& universe, State& state, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double accuracy) {
+    const std::int64_t num_bodies = universe.num_bodies;
+    const double tick = epoch_in_seconds / static_cast<double>(total_ticks);
+
+    // time of the state of every body, in ticks since the start of the epoch
+    std::vector<std::int64_t> times(num_bodies, 0);
+    std::vector<Vector2d<double>> predicted_positions(num_bodies);
+    std::vector<Vector2d<double>> predicted_velocities(num_bodies);
+    std::vector<Vector2d<double>> new_accelerations(num_bodies);
+    std::vector<Vector2d<double>> new_jerks(num_bodies);
+    std::vector<std::int32_t> active;
+    std::uint64_t force_evaluations = 0;
+
+    std::int64_t now = 0;
+    while (now < total_ticks) {
+        std::int64_t next = total_ticks;
+#pragma omp parallel for reduction(min:next) schedule(static)
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            next = std::min(next, times[i] + state.steps[i]);
+        }
+        now = next;
+
+        // predict every body to the step end with its Taylor series
+#pragma omp parallel for schedule(static)
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            const double dt = static_cast<double>(now - times[i]) * tick;
+            const Vector2d<double>& a = state.accelerations[i];
+            const Vector2d<double>& j = state.jerks[i];
+            predicted_positions[i] = universe.positions[i] + universe.velocities[i] * dt + a * (dt * dt / 2.0) + j * (dt * dt * dt / 6.0);
+            predicted_velocities[i] = universe.velocities[i] + a * dt + j * (dt * dt / 2.0);
+        }
+
+        active.clear();
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            if (times[i] + state.steps[i] == now) {
+                active.push_back(static_cast<std::int32_t>(i));
+            }
+        }
+
+        calculate_accelerations_and_jerks(universe, predicted_positions, predicted_velocities, active, new_accelerations, new_jerks);
+        force_evaluations += active.size();
+
+        // Correct with the second and third derivative of the acceleration
+        // from the Hermite interpolation over the step, then pick the next
+        // step from them with the Aarseth criterion. A step may at most double
+        // and has to start at a multiple of its own length.
+#pragma omp parallel for schedule(static)
+        for (std::int64_t k = 0; k < static_cast<std::int64_t>(active.size()); ++k) {
+            const std::int32_t i = active[k];
+            const double dt = static_cast<double>(state.steps[i]) * tick;
+            const Vector2d<double> a0 = state.accelerations[i];
+            const Vector2d<double> j0 = state.jerks[i];
+            const Vector2d<double> a1 = new_accelerations[i];
+            const Vector2d<double> j1 = new_jerks[i];
+
+            const Vector2d<double> snap = ((a0 - a1) * -6.0 - (j0 * 4.0 + j1 * 2.0) * dt) / (dt * dt);
+            const Vector2d<double> crackle = ((a0 - a1) * 12.0 + (j0 + j1) * (6.0 * dt)) / (dt * dt * dt);
+            const double dt2 = dt * dt;
+            universe.positions[i] = predicted_positions[i] + snap * (dt2 * dt2 / 24.0) + crackle * (dt2 * dt2 * dt / 120.0);
+            universe.velocities[i] = predicted_velocities[i] + snap * (dt2 * dt / 6.0) + crackle * (dt2 * dt2 / 24.0);
+            state.accelerations[i] = a1;
+            state.jerks[i] = j1;
+            times[i] = now;
+
+            const Vector2d<double> end_snap = snap + crackle * dt;
+            const double a = std::sqrt(a1.norm2());
+            const double j = std::sqrt(j1.norm2());
+            const double s = std::sqrt(end_snap.norm2());
+            const double c = std::sqrt(crackle.norm2());
+            const double denominator = j * c + s * s;
+            const double step = denominator > 0.0 ? std::sqrt(accuracy * (a * s + j * j) / denominator) : epoch_in_seconds;
+
+            std::int64_t ticks = std::min(quantize_step(step, tick), 2 * state.steps[i]);
+            while (now % ticks != 0) {
+                ticks >>= 1;
+            }
+            state.steps[i] = ticks;
+        }
+    }
+
+    // all bodies end their last step at the epoch boundary
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        universe.forces[i] = state.accelerations[i] * universe.weights[i];
+    }
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+
+    return force_evaluations;
+}
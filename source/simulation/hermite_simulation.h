@@ -0,0 +1,41 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "plotting/plotter.h"
+
+#include <vector>
+
+// Fourth-order Hermite predictor-corrector with direct summation, for small
+// systems that need high accuracy. Accelerations and jerks come from one
+// fused pairwise kernel. Every body has its own power-of-two fraction of the
+// epoch as step, chosen by the Aarseth criterion; at a step end all bodies are
+// predicted to that time and only the bodies whose step ends are corrected.
+// All steps end at the epoch boundaries.
+class HermiteSimulation{
+public:
+    // eta of the Aarseth criterion
+    static constexpr double default_accuracy = 0.02;
+    // eta_s of the first step dt = eta_s |a| / |j|
+    static constexpr double default_initial_accuracy = 0.01;
+    // shortest step epoch_in_seconds / 2^max_level
+    static constexpr std::int32_t max_level = 24;
+
+    // acceleration, jerk and step of every body at the current positions, kept across epochs
+    struct State {
+        std::vector<Vector2d<double>> accelerations;
+        std::vector<Vector2d<double>> jerks;
+        // in ticks of epoch_in_seconds / 2^max_level
+        std::vector<std::int64_t> steps;
+    };
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double accuracy = default_accuracy);
+    // accelerations, jerks and the first steps for the current positions
+    static void initialize(Universe& universe, State& state);
+    // Returns the number of force evaluations of single bodies.
+    static std::uint64_t simulate_epoch(Plotter& plotter, Universe& universe, State& state, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, double accuracy = default_accuracy);
+
+    // Fused kernel: acceleration and jerk of every listed target from all
+    // bodies, at the given positions and velocities.
+    static void calculate_accelerations_and_jerks(const Universe& universe, const std::vector<Vector2d<double>>& positions, const std::vector<Vector2d<double>>& velocities, const std::vector<std::int32_t>& targets, std::vector<Vector2d<double>>& accelerations, std::vector<Vector2d<double>>& jerks);
+};
@@ -0,0 +1,45 @@
+#include "simulation/integrator.h"
+#include "simulation/constants.h"
+
+void Integrator::step(Universe& universe) {
+    // a leapfrog run starts with its opening half kick
+    double kick = epoch_in_seconds;
+    if (integration_scheme == IntegrationScheme::leapfrog && !universe.velocities_staggered) {
+        kick = 0.5 * epoch_in_seconds;
+    }
+    const double drift = epoch_in_seconds;
+
+    const std::int64_t num_bodies = universe.num_bodies;
+    const Vector2d<double>* forces = universe.forces.data();
+    const double* weights = universe.weights.data();
+    Vector2d<double>* velocities = universe.velocities.data();
+    Vector2d<double>* positions = universe.positions.data();
+
+    // v' = v_0 + (F / m) * t_kick, p' = p_0 + v' * t
+#pragma omp parallel for simd schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        const double kick_per_mass = kick / weights[i];
+        const double velocity_x = velocities[i].x + forces[i].x * kick_per_mass;
+        const double velocity_y = velocities[i].y + forces[i].y * kick_per_mass;
+        velocities[i].x = velocity_x;
+        velocities[i].y = velocity_y;
+        positions[i].x += velocity_x * drift;
+        positions[i].y += velocity_y * drift;
+    }
+
+    universe.velocities_staggered = integration_scheme == IntegrationScheme::leapfrog;
+}
+
+void Integrator::synchronize_velocities(Universe& universe) {
+    if (!universe.velocities_staggered) {
+        return;
+    }
+
+    const double kick = 0.5 * epoch_in_seconds;
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(universe.num_bodies); ++i) {
+        universe.velocities[i] += universe.forces[i] * (kick / universe.weights[i]);
+    }
+
+    universe.velocities_staggered = false;
+}
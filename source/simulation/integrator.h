@@ -0,0 +1,32 @@
+#pragma once
+
+
+#include "structures/universe.h"
+
+// Time integration shared by the engines that advance all bodies by whole
+// epochs. BlockTimestepSimulation, HermiteSimulation and the SoA kernels bring
+// their own integrators and ignore integration_scheme. Both schemes move the
+// bodies in one fused pass over the body arrays, kick and drift per body.
+enum class IntegrationScheme : std::uint8_t {
+    // v += a dt, x += v dt; first order
+    symplectic_euler,
+    // kick-drift-kick leapfrog, second order. The closing half kick of an
+    // epoch and the opening half kick of the next one both use the forces at
+    // the same positions, so they are merged into one full kick. The stored
+    // velocities lead the positions by half an epoch between epochs.
+    leapfrog
+};
+
+// selected once before a simulation starts, like softening_length
+inline IntegrationScheme integration_scheme = IntegrationScheme::symplectic_euler;
+
+class Integrator{
+public:
+    // advances velocities and positions by one epoch with universe.forces,
+    // which must hold the forces at the current positions
+    static void step(Universe& universe);
+    // Closing half kick of the leapfrog, brings the velocities back to the
+    // time of the positions, e.g. to measure the energy. universe.forces must
+    // hold the forces at the current positions. No-op for synchronized velocities.
+    static void synchronize_velocities(Universe& universe);
+};
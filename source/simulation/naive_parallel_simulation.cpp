@@ -1,9 +1,13 @@
 #include "simulation/naive_parallel_simulation.h"
 #include "simulation/constants.h"
+#include "simulation/integrator.h"
 #include "physics/gravitation.h"
 #include "physics/mechanics.h"
 
 #include <cmath>
+#include <algorithm>
+#include <omp.h>
+#include <vector>
 
 void NaiveParallelSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
     for (int i = 0; i < num_epochs; i++) {
@@ -13,8 +17,7 @@ void NaiveParallelSimulation::simulate_epochs(Plotter& plotter, Universe& univer
 
 void NaiveParallelSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
     calculate_forces(universe);
-    calculate_velocities(universe);
-    calculate_positions(universe);
+    Integrator::step(universe);
     universe.current_simulation_epoch++;
     if (create_intermediate_plots) {
         if (universe.current_simulation_epoch % plot_intermediate_epochs == 0) {
@@ -26,43 +29,78 @@ void NaiveParallelSimulation::simulate_epoch(Plotter& plotter, Universe& univers
 
 
 void NaiveParallelSimulation::calculate_forces(Universe& universe) {
-    // Initialize forces to zero for all bodies
-#pragma omp parallel for
-    for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
-        universe.forces[i] = Vector2d<double>{ 0.0, 0.0 };
-    }
+    const std::int64_t num_bodies = universe.num_bodies;
+    const double softening_squared = softening_length * softening_length;
 
-    // Compute the forces between all pairs of bodies
-#pragma omp parallel for
-    for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
-        for (std::uint32_t j = i + 1; j < universe.num_bodies; ++j) {
-            // Calculate the displacement vector between body i and body j
-            Vector2d<double> displacement = universe.positions[j] - universe.positions[i];
+    // Every pair is computed once and applied to both bodies (action-reaction
+    // principle). Instead of locking, every thread adds into its own force
+    // buffer; the buffers are summed per body afterwards. They are kept across
+    // calls, so the epochs of a run do not allocate T x N forces each time.
+    // They belong to the calling thread, the team reaches them through the
+    // references.
+    thread_local std::vector<Vector2d<double>> calling_thread_buffers;
+    // first row of every thread, its buffer is only written from there on
+    thread_local std::vector<std::int64_t> calling_thread_first_rows;
+    std::vector<Vector2d<double>>& force_buffers = calling_thread_buffers;
+    std::vector<std::int64_t>& first_rows = calling_thread_first_rows;
 
-            // Compute the distance between body i and body j
-            double distance = std::sqrt(displacement[0] * displacement[0] + displacement[1] * displacement[1]);
+#pragma omp parallel
+    {
+        const std::size_t thread = static_cast<std::size_t>(omp_get_thread_num());
+#pragma omp single
+        {
+            const std::size_t buffer_size = static_cast<std::size_t>(omp_get_num_threads()) * num_bodies;
+            if (force_buffers.size() < buffer_size) {
+                force_buffers.resize(buffer_size);
+            }
+            first_rows.assign(static_cast<std::size_t>(omp_get_num_threads()), num_bodies);
+        }
 
-            // Prevent division by zero if bodies are at the same position
-            if (distance == 0) {
-                throw std::invalid_argument("Bodies are at the same position.");
+        Vector2d<double>* forces = force_buffers.data() + thread * num_bodies;
+        std::int64_t first_row = num_bodies;
+
+        // rows get shorter with i, dynamic scheduling balances the triangle.
+        // Monotonic chunks hand every thread its rows in increasing order, so
+        // row i only touches [first_row, N) of the buffer.
+#pragma omp for schedule(monotonic: dynamic, 16) nowait
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            if (first_row == num_bodies) {
+                first_row = i;
+                std::fill(forces + first_row, forces + num_bodies, Vector2d<double>{ 0.0, 0.0 });
             }
 
-            // Calculate the gravitational force magnitude between the bodies
-            double force_magnitude = gravitational_force(universe.weights[i], universe.weights[j], distance);
+            const Vector2d<double> position = universe.positions[i];
+            const double mass = universe.weights[i];
+            Vector2d<double> row_force{ 0.0, 0.0 };
 
-            // Normalize the displacement vector to get the direction of the force
-            Vector2d<double> force_direction = displacement / distance;
+            for (std::int64_t j = i + 1; j < num_bodies; ++j) {
+                // Calculate the displacement vector between body i and body j
+                Vector2d<double> displacement = universe.positions[j] - position;
 
-            // Calculate the force vector between body i and body j
-            Vector2d<double> force = force_direction * force_magnitude;
+                // F = G * m_i * m_j * r / (r^2 + eps^2)^(3/2), bodies at the
+                // same position without softening do not interact
+                Vector2d<double> force = displacement * (gravitational_constant * mass * universe.weights[j] * softened_inverse_cube(displacement.norm2(), softening_squared));
 
-            // Apply the forces to both bodies (action-reaction principle)
+                row_force += force;
+                forces[j] -= force;
+            }
+            forces[i] += row_force;
+        }
+        first_rows[thread] = first_row;
+#pragma omp barrier
 
-#pragma omp critical
-            {
-                universe.forces[i] = universe.forces[i] + force;
-                universe.forces[j] = universe.forces[j] - force;
+        // Reduce the touched ranges of the buffers, every thread sums a
+        // disjoint range of bodies
+        const std::size_t thread_count = first_rows.size();
+#pragma omp for schedule(static)
+        for (std::int64_t i = 0; i < num_bodies; ++i) {
+            Vector2d<double> total_force{ 0.0, 0.0 };
+            for (std::size_t buffer = 0; buffer < thread_count; ++buffer) {
+                if (first_rows[buffer] <= i) {
+                    total_force += force_buffers[buffer * num_bodies + i];
+                }
             }
+            universe.forces[i] = total_force;
         }
     }
 }
@@ -72,13 +110,8 @@ void NaiveParallelSimulation::calculate_velocities(Universe& universe) {
 #pragma omp parallel for
     for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
         // Calculate the acceleration using Newton's second law: a = F / m
-        Vector2d<double> acceleration = universe.forces[i] / universe.weights[i];
-
-        // Calculate the new velocity: v' = v_0 + a * t
-        Vector2d<double> new_velocity = universe.velocities[i] + acceleration * epoch_in_seconds;
-
-        // Update the velocity for the body in the universe
-        universe.velocities[i] = new_velocity;
+        // and update the velocity in place: v' = v_0 + a * t
+        universe.velocities[i] += universe.forces[i] * (epoch_in_seconds / universe.weights[i]);
     }
 }
 
@@ -86,10 +119,143 @@ void NaiveParallelSimulation::calculate_positions(Universe& universe) {
     // Parallel loop with OpenMP to update positions for all bodies
 #pragma omp parallel for
     for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
-        // Calculate the displacement: s = v * t
-        Vector2d<double> displacement = universe.velocities[i] * epoch_in_seconds;
+        // Update the position with the displacement: p' = p0 + v * t
+        universe.positions[i] += universe.velocities[i] * epoch_in_seconds;
+    }
+}
+
+template <typename Precision>
+void NaiveParallelSimulation::simulate_epochs(Plotter& plotter, BasicUniverseSoA<Precision>& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    for (std::uint32_t i = 0; i < num_epochs; i++) {
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs);
+    }
+}
+
+template <typename Precision>
+void NaiveParallelSimulation::simulate_epoch(Plotter& plotter, BasicUniverseSoA<Precision>& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    calculate_forces(universe);
+    calculate_velocities(universe);
+    calculate_positions(universe);
+    universe.current_simulation_epoch++;
+    if (create_intermediate_plots) {
+        if (universe.current_simulation_epoch % plot_intermediate_epochs == 0) {
+            for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
+                plotter.mark_position(Vector2d<double>(universe.pos_x[i], universe.pos_y[i]), 255, 255, 255);
+            }
+            plotter.write_and_clear();
+        }
+    }
+}
+
+template <typename Precision>
+void NaiveParallelSimulation::calculate_forces(BasicUniverseSoA<Precision>& universe) {
+    using storage_type = typename Precision::storage_type;
+    using compute_type = typename Precision::compute_type;
+    using accumulate_type = typename Precision::accumulate_type;
+
+    const storage_type* pos_x = universe.pos_x.data();
+    const storage_type* pos_y = universe.pos_y.data();
+    const storage_type* weights = universe.weights.data();
+    const std::int64_t num_bodies = universe.num_bodies;
+
+    // Scale lengths to the extent of the universe and masses to the heaviest
+    // body. The unit factors are pulled out of the sum and applied once per
+    // body in double, so the pairwise terms stay around 1 in every precision.
+    BoundingBox bb = universe.get_bounding_box();
+    double length_unit = std::max(bb.x_max - bb.x_min, bb.y_max - bb.y_min);
+    length_unit = length_unit > 0.0 ? length_unit : 1.0;
+    double mass_unit = 0.0;
+#pragma omp parallel for reduction(max: mass_unit)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        mass_unit = weights[i] > mass_unit ? static_cast<double>(weights[i]) : mass_unit;
+    }
+    mass_unit = mass_unit > 0.0 ? mass_unit : 1.0;
+
+    const storage_type inverse_length_unit = static_cast<storage_type>(1.0 / length_unit);
+    const storage_type inverse_mass_unit = static_cast<storage_type>(1.0 / mass_unit);
+    const double unit_factor = gravitational_constant * mass_unit / (length_unit * length_unit);
+    const compute_type softening_squared = static_cast<compute_type>((softening_length / length_unit) * (softening_length / length_unit));
+
+    // Every thread owns complete rows i, so no synchronization is needed. The
+    // inner loop runs over the contiguous columns and vectorizes; without
+    // softening the self interaction is masked out instead of branched around.
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        const storage_type body_x = pos_x[i];
+        const storage_type body_y = pos_y[i];
+        accumulate_type force_x = 0;
+        accumulate_type force_y = 0;
+
+#pragma omp simd reduction(+: force_x, force_y)
+        for (std::int64_t j = 0; j < num_bodies; ++j) {
+            // the difference is formed in storage precision and only then narrowed
+            const compute_type dx = static_cast<compute_type>((pos_x[j] - body_x) * inverse_length_unit);
+            const compute_type dy = static_cast<compute_type>((pos_y[j] - body_y) * inverse_length_unit);
+            const compute_type mass = static_cast<compute_type>(weights[j] * inverse_mass_unit);
+            const compute_type distance_squared = dx * dx + dy * dy + softening_squared;
+            const compute_type contributes = (distance_squared > compute_type(0)) ? compute_type(1) : compute_type(0);
+            const compute_type safe_distance_squared = distance_squared + (compute_type(1) - contributes);
+
+            // F = G * m_i * m_j * (dx, dy) / (r^2 + eps^2)^(3/2)
+            const compute_type inverse_distance = compute_type(1) / std::sqrt(safe_distance_squared);
+            const compute_type scale = contributes * mass * inverse_distance * inverse_distance * inverse_distance;
+            force_x += static_cast<accumulate_type>(dx * scale);
+            force_y += static_cast<accumulate_type>(dy * scale);
+        }
 
-        // Update the position: p' = p0 + s
-        universe.positions[i] = universe.positions[i] + displacement;
+        const double body_factor = unit_factor * static_cast<double>(weights[i]);
+        universe.force_x[i] = static_cast<accumulate_type>(force_x * body_factor);
+        universe.force_y[i] = static_cast<accumulate_type>(force_y * body_factor);
     }
-}
\ No newline at end of file
+}
+
+template <typename Precision>
+void NaiveParallelSimulation::calculate_velocities(BasicUniverseSoA<Precision>& universe) {
+    using storage_type = typename Precision::storage_type;
+    using accumulate_type = typename Precision::accumulate_type;
+
+    const std::int64_t num_bodies = universe.num_bodies;
+    storage_type* vel_x = universe.vel_x.data();
+    storage_type* vel_y = universe.vel_y.data();
+    const accumulate_type* force_x = universe.force_x.data();
+    const accumulate_type* force_y = universe.force_y.data();
+    const storage_type* weights = universe.weights.data();
+
+    // v' = v_0 + (F / m) * t
+#pragma omp parallel for simd schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        const storage_type time_per_mass = static_cast<storage_type>(epoch_in_seconds) / weights[i];
+        vel_x[i] += static_cast<storage_type>(force_x[i]) * time_per_mass;
+        vel_y[i] += static_cast<storage_type>(force_y[i]) * time_per_mass;
+    }
+}
+
+template <typename Precision>
+void NaiveParallelSimulation::calculate_positions(BasicUniverseSoA<Precision>& universe) {
+    using storage_type = typename Precision::storage_type;
+
+    const std::int64_t num_bodies = universe.num_bodies;
+    storage_type* pos_x = universe.pos_x.data();
+    storage_type* pos_y = universe.pos_y.data();
+    const storage_type* vel_x = universe.vel_x.data();
+    const storage_type* vel_y = universe.vel_y.data();
+    const storage_type time_step = static_cast<storage_type>(epoch_in_seconds);
+
+    // p' = p_0 + v * t
+#pragma omp parallel for simd schedule(static)
+    for (std::int64_t i = 0; i < num_bodies; ++i) {
+        pos_x[i] += vel_x[i] * time_step;
+        pos_y[i] += vel_y[i] * time_step;
+    }
+}
+
+#define INSTANTIATE_SOA_KERNELS(Precision) \
+    template void NaiveParallelSimulation::simulate_epochs<Precision>(Plotter&, BasicUniverseSoA<Precision>&, std::uint32_t, bool, std::uint32_t); \
+    template void NaiveParallelSimulation::simulate_epoch<Precision>(Plotter&, BasicUniverseSoA<Precision>&, bool, std::uint32_t); \
+    template void NaiveParallelSimulation::calculate_velocities<Precision>(BasicUniverseSoA<Precision>&); \
+    template void NaiveParallelSimulation::calculate_positions<Precision>(BasicUniverseSoA<Precision>&); \
+    template void NaiveParallelSimulation::calculate_forces<Precision>(BasicUniverseSoA<Precision>&);
+
+INSTANTIATE_SOA_KERNELS(DoublePrecision)
+INSTANTIATE_SOA_KERNELS(FloatPrecision)
+INSTANTIATE_SOA_KERNELS(FloatComputePrecision)
@@ -2,6 +2,7 @@
 
 
 #include "structures/universe.h"
+#include "structures/universe_soa.h"
 #include "plotting/plotter.h"
 
 class NaiveParallelSimulation{
@@ -11,4 +12,12 @@ public:
     static void calculate_velocities(Universe& universe);
     static void calculate_positions(Universe& universe);
     static void calculate_forces(Universe& universe);
+
+    // structure-of-arrays variants of the kernels above, instantiated for the
+    // precision policies in structures/precision.h
+    template <typename Precision> static void simulate_epochs(Plotter& plotter, BasicUniverseSoA<Precision>& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    template <typename Precision> static void simulate_epoch(Plotter& plotter, BasicUniverseSoA<Precision>& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    template <typename Precision> static void calculate_velocities(BasicUniverseSoA<Precision>& universe);
+    template <typename Precision> static void calculate_positions(BasicUniverseSoA<Precision>& universe);
+    template <typename Precision> static void calculate_forces(BasicUniverseSoA<Precision>& universe);
 };
\ No newline at end of file
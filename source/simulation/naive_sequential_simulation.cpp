@@ -1,5 +1,6 @@
 #include "simulation/naive_sequential_simulation.h"
 #include "simulation/constants.h"
+#include "simulation/integrator.h"
 #include "physics/gravitation.h"
 #include "physics/mechanics.h"
 
@@ -15,8 +16,7 @@ void NaiveSequentialSimulation::simulate_epochs(Plotter& plotter, Universe& univ
 
 void NaiveSequentialSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs){
     calculate_forces(universe);
-    calculate_velocities(universe);
-    calculate_positions(universe);
+    Integrator::step(universe);
     universe.current_simulation_epoch++;
     if(create_intermediate_plots){
         if((universe.current_simulation_epoch % plot_intermediate_epochs) == 0){
@@ -28,6 +28,7 @@ void NaiveSequentialSimulation::simulate_epoch(Plotter& plotter, Universe& unive
 
 
 void NaiveSequentialSimulation::calculate_forces(Universe& universe){
+    const double softening_squared = softening_length * softening_length;
     for(int body_idx = 0; body_idx < universe.num_bodies; body_idx++){
         // get body positions
         Vector2d<double> body_position = universe.positions[body_idx];
@@ -47,14 +48,12 @@ void NaiveSequentialSimulation::calculate_forces(Universe& universe){
             // calculate vector between bodies to get the direction of the gravitational force
             Vector2d<double> direction_vector = distant_body_position - body_position;
 
-            // calculate the distance between the bodies
-            double distance = sqrt(pow(direction_vector[0], 2) + pow(direction_vector[1], 2));
-
-            // calculate gravitational force between the bodies
-            double force = gravitational_force(body_mass, universe.weights[distant_body_idx], distance);
+            // calculate the softened gravitational force between the bodies
+            // F = G * m_i * m_j * r / (r^2 + eps^2)^(3/2)
+            double force = gravitational_constant * body_mass * universe.weights[distant_body_idx] * softened_inverse_cube(direction_vector.norm2(), softening_squared);
 
             // create the force vector
-            Vector2d<double> force_vector = direction_vector * (force / distance);
+            Vector2d<double> force_vector = direction_vector * force;
 
             // sum forces applied to body
             applied_force_vector = applied_force_vector + force_vector;
@@ -0,0 +1,271 @@
+#include "simulation/naive_simd_simulation.h"
+#include "simulation/integrator.h"
+#include "structures/aligned_allocator.h"
+#include "physics/gravitation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NAIVE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// target bodies per tile and the padding of the source columns (one AVX-512 vector)
+static const std::int64_t tile_size = 4;
+static const std::int64_t column_padding = 8;
+
+// Positions in units of the extent of the universe and G * m_j in units of the
+// heaviest body, like the SoA kernels of NaiveParallelSimulation. Keeps r^2
+// around 1, inside the range of the single precision rsqrt estimate. The
+// padding has G * m_j = 0 and contributes nothing.
+struct SourceColumns {
+    AlignedVector<double> x, y, gm;
+    std::int64_t count = 0;
+    std::int64_t padded_count = 0;
+    double length_unit = 1.0;
+    double mass_unit = 1.0;
+    // softening length in units of the columns, squared
+    double softening_squared = 0.0;
+};
+
+static void fill_columns(Universe& universe, SourceColumns& columns) {
+    BoundingBox bb = universe.get_bounding_box();
+    double length_unit = std::max(bb.x_max - bb.x_min, bb.y_max - bb.y_min);
+    columns.length_unit = length_unit > 0.0 ? length_unit : 1.0;
+    double mass_unit = 0.0;
+    for (std::uint32_t i = 0; i < universe.num_bodies; ++i) {
+        mass_unit = std::max(mass_unit, universe.weights[i]);
+    }
+    columns.mass_unit = mass_unit > 0.0 ? mass_unit : 1.0;
+
+    columns.count = universe.num_bodies;
+    columns.padded_count = (columns.count + column_padding - 1) / column_padding * column_padding;
+    columns.x.assign(columns.padded_count, 0.0);
+    columns.y.assign(columns.padded_count, 0.0);
+    columns.gm.assign(columns.padded_count, 0.0);
+
+    const double inverse_length_unit = 1.0 / columns.length_unit;
+    columns.softening_squared = (softening_length * inverse_length_unit) * (softening_length * inverse_length_unit);
+    const double inverse_mass_unit = 1.0 / columns.mass_unit;
+#pragma omp parallel for
+    for (std::int64_t j = 0; j < columns.count; ++j) {
+        columns.x[j] = (universe.positions[j].x - bb.x_min) * inverse_length_unit;
+        columns.y[j] = (universe.positions[j].y - bb.y_min) * inverse_length_unit;
+        columns.gm[j] = universe.weights[j] * inverse_mass_unit;
+    }
+}
+
+// Every tile computes sum_j G m_j d / (r^2 + eps^2)^(3/2) for targets
+// [i, i + tile_size), in the units of the columns. Without softening, sources
+// at r = 0 (the target itself) are masked out.
+static void tile_scalar(const SourceColumns& columns, std::int64_t i, double* acceleration_x, double* acceleration_y) {
+    for (std::int64_t t = 0; t < tile_size; ++t) {
+        const double body_x = columns.x[i + t];
+        const double body_y = columns.y[i + t];
+        double sum_x = 0.0;
+        double sum_y = 0.0;
+        for (std::int64_t j = 0; j < columns.padded_count; ++j) {
+            const double dx = columns.x[j] - body_x;
+            const double dy = columns.y[j] - body_y;
+            const double scale = columns.gm[j] * softened_inverse_cube(dx * dx + dy * dy, columns.softening_squared);
+            sum_x += dx * scale;
+            sum_y += dy * scale;
+        }
+        acceleration_x[i + t] = sum_x;
+        acceleration_y[i + t] = sum_y;
+    }
+}
+
+#ifdef NAIVE_SIMD_X86
+
+__attribute__((target("avx2,fma")))
+static double horizontal_sum_avx2(__m256d value) {
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+__attribute__((target("avx2,fma")))
+static void tile_avx2(const SourceColumns& columns, std::int64_t i, double* acceleration_x, double* acceleration_y) {
+    __m256d body_x[tile_size], body_y[tile_size], sum_x[tile_size], sum_y[tile_size];
+    for (std::int64_t t = 0; t < tile_size; ++t) {
+        body_x[t] = _mm256_set1_pd(columns.x[i + t]);
+        body_y[t] = _mm256_set1_pd(columns.y[i + t]);
+        sum_x[t] = _mm256_setzero_pd();
+        sum_y[t] = _mm256_setzero_pd();
+    }
+
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d softening_squared = _mm256_set1_pd(columns.softening_squared);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_halves = _mm256_set1_pd(1.5);
+
+    for (std::int64_t j = 0; j < columns.padded_count; j += 4) {
+        const __m256d x = _mm256_load_pd(columns.x.data() + j);
+        const __m256d y = _mm256_load_pd(columns.y.data() + j);
+        const __m256d gm = _mm256_load_pd(columns.gm.data() + j);
+        for (std::int64_t t = 0; t < tile_size; ++t) {
+            const __m256d dx = _mm256_sub_pd(x, body_x[t]);
+            const __m256d dy = _mm256_sub_pd(y, body_y[t]);
+            const __m256d r_squared = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, softening_squared));
+            const __m256d contributes = _mm256_cmp_pd(r_squared, zero, _CMP_GT_OQ);
+            const __m256d safe_r_squared = _mm256_blendv_pd(one, r_squared, contributes);
+
+            // 12 bit estimate in single precision, three Newton steps
+            // y' = y (3/2 - r^2 y^2 / 2) refine it to a few ulp of 1 / r
+            __m256d inverse_r = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(safe_r_squared)));
+            const __m256d half_r_squared = _mm256_mul_pd(half, safe_r_squared);
+            for (int step = 0; step < 3; ++step) {
+                inverse_r = _mm256_mul_pd(inverse_r, _mm256_fnmadd_pd(half_r_squared, _mm256_mul_pd(inverse_r, inverse_r), three_halves));
+            }
+
+            const __m256d inverse_r3 = _mm256_mul_pd(_mm256_mul_pd(inverse_r, inverse_r), inverse_r);
+            const __m256d scale = _mm256_and_pd(contributes, _mm256_mul_pd(gm, inverse_r3));
+            sum_x[t] = _mm256_fmadd_pd(dx, scale, sum_x[t]);
+            sum_y[t] = _mm256_fmadd_pd(dy, scale, sum_y[t]);
+        }
+    }
+
+    for (std::int64_t t = 0; t < tile_size; ++t) {
+        acceleration_x[i + t] = horizontal_sum_avx2(sum_x[t]);
+        acceleration_y[i + t] = horizontal_sum_avx2(sum_y[t]);
+    }
+}
+
+// GCC 12 warns about the _mm512_undefined_pd sources that the unmasked forms
+// of _mm512_reduce_add_pd, _mm512_extractf64x4_pd and _mm512_rsqrt14_pd pass
+// internally, so the kernel uses their zero masked forms with all lanes set
+static const __mmask8 all_lanes = 0xFF;
+
+__attribute__((target("avx512f")))
+static double horizontal_sum_avx512(__m512d value) {
+    const __m256d low = _mm512_maskz_extractf64x4_pd(all_lanes, value, 0);
+    const __m256d high = _mm512_maskz_extractf64x4_pd(all_lanes, value, 1);
+    return horizontal_sum_avx2(_mm256_add_pd(low, high));
+}
+
+__attribute__((target("avx512f")))
+static void tile_avx512(const SourceColumns& columns, std::int64_t i, double* acceleration_x, double* acceleration_y) {
+    __m512d body_x[tile_size], body_y[tile_size], sum_x[tile_size], sum_y[tile_size];
+    for (std::int64_t t = 0; t < tile_size; ++t) {
+        body_x[t] = _mm512_set1_pd(columns.x[i + t]);
+        body_y[t] = _mm512_set1_pd(columns.y[i + t]);
+        sum_x[t] = _mm512_setzero_pd();
+        sum_y[t] = _mm512_setzero_pd();
+    }
+
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d softening_squared = _mm512_set1_pd(columns.softening_squared);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+
+    for (std::int64_t j = 0; j < columns.padded_count; j += 8) {
+        const __m512d x = _mm512_load_pd(columns.x.data() + j);
+        const __m512d y = _mm512_load_pd(columns.y.data() + j);
+        const __m512d gm = _mm512_load_pd(columns.gm.data() + j);
+        for (std::int64_t t = 0; t < tile_size; ++t) {
+            const __m512d dx = _mm512_sub_pd(x, body_x[t]);
+            const __m512d dy = _mm512_sub_pd(y, body_y[t]);
+            const __m512d r_squared = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, softening_squared));
+            const __mmask8 contributes = _mm512_cmp_pd_mask(r_squared, zero, _CMP_GT_OQ);
+            const __m512d safe_r_squared = _mm512_mask_blend_pd(contributes, one, r_squared);
+
+            // 14 bit estimate, two Newton steps refine it to a few ulp of 1 / r
+            __m512d inverse_r = _mm512_maskz_rsqrt14_pd(all_lanes, safe_r_squared);
+            const __m512d half_r_squared = _mm512_mul_pd(half, safe_r_squared);
+            for (int step = 0; step < 2; ++step) {
+                inverse_r = _mm512_mul_pd(inverse_r, _mm512_fnmadd_pd(half_r_squared, _mm512_mul_pd(inverse_r, inverse_r), three_halves));
+            }
+
+            const __m512d inverse_r3 = _mm512_mul_pd(_mm512_mul_pd(inverse_r, inverse_r), inverse_r);
+            const __m512d scale = _mm512_maskz_mul_pd(contributes, gm, inverse_r3);
+            sum_x[t] = _mm512_fmadd_pd(dx, scale, sum_x[t]);
+            sum_y[t] = _mm512_fmadd_pd(dy, scale, sum_y[t]);
+        }
+    }
+
+    for (std::int64_t t = 0; t < tile_size; ++t) {
+        acceleration_x[i + t] = horizontal_sum_avx512(sum_x[t]);
+        acceleration_y[i + t] = horizontal_sum_avx512(sum_y[t]);
+    }
+}
+
+#endif
+
+bool NaiveSimdSimulation::is_supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::scalar:
+            return true;
+#ifdef NAIVE_SIMD_X86
+        case Kernel::avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Kernel::avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+NaiveSimdSimulation::Kernel NaiveSimdSimulation::detect_kernel() {
+    static const Kernel kernel = is_supported(Kernel::avx512) ? Kernel::avx512 : (is_supported(Kernel::avx2) ? Kernel::avx2 : Kernel::scalar);
+    return kernel;
+}
+
+void NaiveSimdSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    for (std::uint32_t i = 0; i < num_epochs; i++) {
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs);
+    }
+}
+
+void NaiveSimdSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs) {
+    calculate_forces(universe);
+    Integrator::step(universe);
+    universe.current_simulation_epoch++;
+    if (create_intermediate_plots) {
+        if (universe.current_simulation_epoch % plot_intermediate_epochs == 0) {
+            plotter.add_bodies_to_image(universe);
+            plotter.write_and_clear();
+        }
+    }
+}
+
+void NaiveSimdSimulation::calculate_forces(Universe& universe) {
+    calculate_forces(universe, detect_kernel());
+}
+
+void NaiveSimdSimulation::calculate_forces(Universe& universe, Kernel kernel) {
+    if (!is_supported(kernel)) {
+        throw std::invalid_argument("the CPU does not support the requested kernel");
+    }
+
+    SourceColumns columns;
+    fill_columns(universe, columns);
+
+    void (*tile)(const SourceColumns&, std::int64_t, double*, double*) = tile_scalar;
+#ifdef NAIVE_SIMD_X86
+    if (kernel == Kernel::avx2) {
+        tile = tile_avx2;
+    }
+    else if (kernel == Kernel::avx512) {
+        tile = tile_avx512;
+    }
+#endif
+
+    // the padded columns hold whole tiles, the padding targets are discarded
+    AlignedVector<double> acceleration_x(columns.padded_count);
+    AlignedVector<double> acceleration_y(columns.padded_count);
+#pragma omp parallel for schedule(dynamic, 4)
+    for (std::int64_t i = 0; i < columns.padded_count; i += tile_size) {
+        tile(columns, i, acceleration_x.data(), acceleration_y.data());
+    }
+
+    const double unit_factor = gravitational_constant * columns.mass_unit / (columns.length_unit * columns.length_unit);
+#pragma omp parallel for
+    for (std::int64_t i = 0; i < columns.count; ++i) {
+        universe.forces[i] = Vector2d<double>(acceleration_x[i], acceleration_y[i]) * (unit_factor * universe.weights[i]);
+    }
+}
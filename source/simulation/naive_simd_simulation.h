@@ -0,0 +1,28 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "plotting/plotter.h"
+
+// Direct summation with explicit SIMD kernels, meant as the fast ground truth
+// for accuracy runs. Positions and G * m_j are copied into padded, aligned
+// columns; tiles of four target bodies are kept in registers while the source
+// columns stream past them. The softened 1 / r is formed with rsqrt and
+// Newton steps. The kernel is chosen at runtime from the features of the CPU.
+class NaiveSimdSimulation{
+public:
+    enum class Kernel : std::uint8_t {
+        scalar,
+        avx2,
+        avx512
+    };
+
+    // widest kernel the CPU supports
+    static Kernel detect_kernel();
+    static bool is_supported(Kernel kernel);
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    static void simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs);
+    static void calculate_forces(Universe& universe);
+    static void calculate_forces(Universe& universe, Kernel kernel);
+};
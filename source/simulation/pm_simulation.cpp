@@ -0,0 +1,172 @@
+#include "simulation/pm_simulation.h"
+#include "simulation/integrator.h"
+#include "physics/gravitation.h"
+#include "utilities/fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <omp.h>
+#include <stdexcept>
+#include <vector>
+
+void PmSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size){
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs, grid_size);
+    }
+}
+
+void PmSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size){
+    calculate_forces(universe, grid_size);
+
+    Integrator::step(universe);
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+}
+
+// Grid nodes sit at origin + (col, row) * cell_width. The bounding box spans
+// size - 2 cells, so the upper cloud-in-cell partner of every body is a node.
+struct MeshGeometry {
+    Vector2d<double> origin;
+    double cell_width = 1.0;
+    std::int64_t size = 0;
+};
+
+// lower node of the cell holding the position and the weights of the upper nodes
+static void cloud_in_cell(const MeshGeometry& mesh, const Vector2d<double>& position, std::int64_t& col, std::int64_t& row, double& weight_x, double& weight_y) {
+    const double x = (position.x - mesh.origin.x) / mesh.cell_width;
+    const double y = (position.y - mesh.origin.y) / mesh.cell_width;
+    col = std::clamp(static_cast<std::int64_t>(x), std::int64_t{0}, mesh.size - 2);
+    row = std::clamp(static_cast<std::int64_t>(y), std::int64_t{0}, mesh.size - 2);
+    weight_x = x - static_cast<double>(col);
+    weight_y = y - static_cast<double>(row);
+}
+
+// Masses of the bodies on the nodes. Every thread deposits into its own grid,
+// the grids are summed per node afterwards, like the force buffers of
+// NaiveParallelSimulation.
+static void deposit_masses(Universe& universe, const MeshGeometry& mesh, std::vector<double>& masses) {
+    const std::int64_t nodes = mesh.size * mesh.size;
+    std::vector<double> thread_masses;
+
+#pragma omp parallel
+    {
+#pragma omp single
+        thread_masses.assign(static_cast<std::size_t>(omp_get_num_threads()) * nodes, 0.0);
+
+        double* grid = thread_masses.data() + static_cast<std::size_t>(omp_get_thread_num()) * nodes;
+#pragma omp for schedule(static)
+        for (std::int64_t i = 0; i < static_cast<std::int64_t>(universe.num_bodies); ++i) {
+            std::int64_t col, row;
+            double weight_x, weight_y;
+            cloud_in_cell(mesh, universe.positions[i], col, row, weight_x, weight_y);
+            const double mass = universe.weights[i];
+            grid[row * mesh.size + col] += mass * (1.0 - weight_x) * (1.0 - weight_y);
+            grid[row * mesh.size + col + 1] += mass * weight_x * (1.0 - weight_y);
+            grid[(row + 1) * mesh.size + col] += mass * (1.0 - weight_x) * weight_y;
+            grid[(row + 1) * mesh.size + col + 1] += mass * weight_x * weight_y;
+        }
+
+#pragma omp for schedule(static)
+        for (std::int64_t node = 0; node < nodes; ++node) {
+            double mass = 0.0;
+            for (std::size_t buffer = 0; buffer < thread_masses.size(); buffer += nodes) {
+                mass += thread_masses[buffer + node];
+            }
+            masses[node] = mass;
+        }
+    }
+}
+
+static MeshGeometry mesh_geometry(Universe& universe, std::int32_t grid_size) {
+    if (grid_size < 4 || (grid_size & (grid_size - 1)) != 0) {
+        throw std::invalid_argument("the grid size must be a power of two of at least 4");
+    }
+
+    MeshGeometry mesh;
+    mesh.size = grid_size;
+    BoundingBox bb = universe.get_bounding_box();
+    double extent = std::max(bb.x_max - bb.x_min, bb.y_max - bb.y_min);
+    mesh.cell_width = (extent > 0.0 ? extent : 1.0) / static_cast<double>(mesh.size - 2);
+    mesh.origin = Vector2d<double>(bb.x_min, bb.y_min);
+    return mesh;
+}
+
+double PmSimulation::cell_width(Universe& universe, std::int32_t grid_size) {
+    return mesh_geometry(universe, grid_size).cell_width;
+}
+
+void PmSimulation::calculate_forces(Universe& universe, std::int32_t grid_size) {
+    calculate_long_range_forces(universe, grid_size, 0.0);
+}
+
+// A split radius of 0 selects the full kernel.
+void PmSimulation::calculate_long_range_forces(Universe& universe, std::int32_t grid_size, double split_radius) {
+    MeshGeometry mesh = mesh_geometry(universe, grid_size);
+
+    std::vector<double> masses(mesh.size * mesh.size);
+    deposit_masses(universe, mesh, masses);
+
+    // The acceleration on node p is G * sum_q m_q H(p - q) with the kernel
+    // H(e) = -e h / |e h|^3 of a point mass, softened like every other engine.
+    // Both components are convolved at once as H_x + i H_y; the masses are real,
+    // so the real and imaginary part of the result stay apart. Zero padding to
+    // twice the size keeps the cyclic convolution from wrapping around.
+    const std::int64_t padded_size = 2 * mesh.size;
+    std::vector<std::complex<double>> padded_masses(padded_size * padded_size);
+    std::vector<std::complex<double>> kernel(padded_size * padded_size);
+    const double softening_squared = softening_length * softening_length;
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t row = 0; row < padded_size; ++row) {
+        for (std::int64_t col = 0; col < padded_size; ++col) {
+            if (row < mesh.size && col < mesh.size) {
+                padded_masses[row * padded_size + col] = masses[row * mesh.size + col];
+            }
+            // displacements beyond +-(size - 1) cells do not occur
+            if (row == mesh.size || col == mesh.size) {
+                continue;
+            }
+            const double dx = static_cast<double>(col < mesh.size ? col : col - padded_size) * mesh.cell_width;
+            const double dy = static_cast<double>(row < mesh.size ? row : row - padded_size) * mesh.cell_width;
+            const double r_squared = dx * dx + dy * dy;
+            double factor = -softened_inverse_cube(r_squared, softening_squared);
+            if (split_radius > 0.0) {
+                const double r = std::sqrt(r_squared);
+                const double u = r / (2.0 * split_radius);
+                factor *= std::erf(u) - 2.0 * u / std::sqrt(std::numbers::pi) * std::exp(-u * u);
+            }
+            kernel[row * padded_size + col] = std::complex<double>(dx * factor, dy * factor);
+        }
+    }
+
+    fft_2d(padded_masses, padded_size, false);
+    fft_2d(kernel, padded_size, false);
+    const double normalization = gravitational_constant / static_cast<double>(padded_size * padded_size);
+#pragma omp parallel for schedule(static)
+    for (std::int64_t node = 0; node < padded_size * padded_size; ++node) {
+        padded_masses[node] *= kernel[node] * normalization;
+    }
+    fft_2d(padded_masses, padded_size, true);
+    const std::vector<std::complex<double>>& accelerations = padded_masses;
+
+    // interpolate with the weights of the deposit, so a body exerts no force on itself
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(universe.num_bodies); ++i) {
+        std::int64_t col, row;
+        double weight_x, weight_y;
+        cloud_in_cell(mesh, universe.positions[i], col, row, weight_x, weight_y);
+        const std::complex<double> acceleration =
+            accelerations[row * padded_size + col] * ((1.0 - weight_x) * (1.0 - weight_y)) +
+            accelerations[row * padded_size + col + 1] * (weight_x * (1.0 - weight_y)) +
+            accelerations[(row + 1) * padded_size + col] * ((1.0 - weight_x) * weight_y) +
+            accelerations[(row + 1) * padded_size + col + 1] * (weight_x * weight_y);
+        universe.forces[i] = Vector2d<double>(acceleration.real(), acceleration.imag()) * universe.weights[i];
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "plotting/plotter.h"
+
+// Particle-mesh gravity for large, roughly uniform systems. Masses are
+// deposited onto a square grid over the bounding box with cloud-in-cell
+// weights, the grid is convolved with the force kernel of the point mass by
+// FFT and the accelerations are interpolated back to the bodies with the same
+// weights. The grid is zero padded to twice its size, so the boundaries are
+// open and not periodic. Forces below a few cells are smoothed out.
+class PmSimulation{
+public:
+    // cells per side, a power of two
+    static constexpr std::int32_t default_grid_size = 256;
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size = default_grid_size);
+    static void simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size = default_grid_size);
+    static void calculate_forces(Universe& universe, std::int32_t grid_size = default_grid_size);
+    // Long-range part of the Gaussian force split of TreePM, the kernel is
+    // multiplied by erf(r / 2 r_s) - r / (r_s sqrt(pi)) exp(-r^2 / 4 r_s^2)
+    static void calculate_long_range_forces(Universe& universe, std::int32_t grid_size, double split_radius);
+
+    // width of the cells calculate_forces uses for this universe
+    static double cell_width(Universe& universe, std::int32_t grid_size);
+};
@@ -0,0 +1,124 @@
+#include "simulation/tree_pm_simulation.h"
+#include "simulation/integrator.h"
+#include "simulation/pm_simulation.h"
+#include "physics/gravitation.h"
+
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+void TreePmSimulation::simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size){
+    for(std::uint32_t i = 0; i < num_epochs; i++){
+        simulate_epoch(plotter, universe, create_intermediate_plots, plot_intermediate_epochs, grid_size);
+    }
+}
+
+void TreePmSimulation::simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size){
+    Quadtree quadtree(universe, universe.get_bounding_box(), 2, QuadtreeNodeArena::epoch_arena(), default_leaf_capacity);
+
+    calculate_forces(universe, quadtree, grid_size);
+
+    Integrator::step(universe);
+
+    universe.current_simulation_epoch++;
+
+    if (create_intermediate_plots && (universe.current_simulation_epoch % plot_intermediate_epochs == 0)) {
+        plotter.add_bodies_to_image(universe);
+        plotter.write_and_clear();
+    }
+}
+
+void TreePmSimulation::calculate_forces(Universe& universe, Quadtree& quadtree, std::int32_t grid_size, double threshold_theta){
+    const double split_radius = default_split_cells * PmSimulation::cell_width(universe, grid_size);
+
+    PmSimulation::calculate_long_range_forces(universe, grid_size, split_radius);
+    add_short_range_forces(universe, quadtree, split_radius, default_cutoff_splits * split_radius, threshold_theta);
+}
+
+// Share of the pair force at distance r that belongs to the tree,
+// u = r / 2 r_s. The mesh kernel carries the rest.
+static inline double short_range_factor(double u) {
+    return std::erfc(u) + 2.0 * u / std::sqrt(std::numbers::pi) * std::exp(-u * u);
+}
+
+// Short-range force on body i from the bodies of a leaf, pairs beyond the cutoff are masked.
+static Vector2d<double> short_range_leaf_force(Universe& universe, std::int32_t i, std::span<const std::int32_t> bodies, double inverse_split_diameter, double cutoff_squared) {
+    const Vector2d<double> position = universe.positions[i];
+    const std::int32_t* indices = bodies.data();
+    const std::int32_t count = static_cast<std::int32_t>(bodies.size());
+    const double softening_squared = softening_length * softening_length;
+
+    double force_x = 0.0;
+    double force_y = 0.0;
+#pragma omp simd reduction(+:force_x, force_y)
+    for (std::int32_t k = 0; k < count; ++k) {
+        const std::int32_t j = indices[k];
+        const double dx = universe.positions[j].x - position.x;
+        const double dy = universe.positions[j].y - position.y;
+        const double r_squared = dx * dx + dy * dy;
+        const double split = r_squared < cutoff_squared ? short_range_factor(std::sqrt(r_squared) * inverse_split_diameter) : 0.0;
+        const double factor = universe.weights[j] * split * softened_inverse_cube(r_squared, softening_squared);
+        force_x += dx * factor;
+        force_y += dy * factor;
+    }
+
+    return Vector2d<double>(force_x, force_y) * (gravitational_constant * universe.weights[i]);
+}
+
+// Same single pass walk as BarnesHutSimulation::calculate_forces, except that
+// nodes whose box lies beyond the cutoff are dropped without being opened.
+static Vector2d<double> short_range_force(Universe& universe, Quadtree& quadtree, std::int32_t i, double inverse_split_diameter, double cutoff_radius, double threshold_theta) {
+    thread_local std::vector<QuadtreeNode*> stack;
+    stack.clear();
+    stack.push_back(quadtree.root);
+
+    const double threshold_theta_squared = threshold_theta * threshold_theta;
+    const double cutoff_squared = cutoff_radius * cutoff_radius;
+    const double softening_squared = softening_length * softening_length;
+    const Vector2d<double> position = universe.positions[i];
+    Vector2d<double> total_force(0.0, 0.0);
+
+    while (!stack.empty()) {
+        QuadtreeNode* node = stack.back();
+        stack.pop_back();
+
+        if (node->bounding_box.get_distance(position) > cutoff_radius) {
+            continue;
+        }
+
+        if (node->children.empty()) {
+            if (node->bodies.empty() || (node->bodies.size() == 1 && node->body_identifier == i)) {
+                continue;
+            }
+            total_force += short_range_leaf_force(universe, i, node->bodies, inverse_split_diameter, cutoff_squared);
+            continue;
+        }
+
+        double d_squared = node->size_squared;
+        Vector2d<double> delta = node->center_of_mass - position;
+        double r_squared = delta.norm2();
+        if (d_squared < threshold_theta_squared * r_squared) {
+            if (r_squared < cutoff_squared) {
+                double split = short_range_factor(std::sqrt(r_squared) * inverse_split_diameter);
+                total_force += delta * (gravitational_constant * universe.weights[i] * node->cumulative_mass * split * softened_inverse_cube(r_squared, softening_squared));
+            }
+            continue;
+        }
+
+        for (QuadtreeNode* child : node->children) {
+            stack.push_back(child);
+        }
+    }
+
+    return total_force;
+}
+
+void TreePmSimulation::add_short_range_forces(Universe& universe, Quadtree& quadtree, double split_radius, double cutoff_radius, double threshold_theta){
+    const double inverse_split_diameter = 1.0 / (2.0 * split_radius);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(universe.num_bodies); ++i) {
+        universe.forces[i] += short_range_force(universe, quadtree, i, inverse_split_diameter, cutoff_radius, threshold_theta);
+    }
+}
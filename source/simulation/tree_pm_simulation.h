@@ -0,0 +1,31 @@
+#pragma once
+
+
+#include "structures/universe.h"
+#include "quadtree/quadtree.h"
+#include "plotting/plotter.h"
+
+// TreePM: the force is split with a Gaussian of width r_s into a long-range
+// part, solved on the mesh of PmSimulation, and a short-range part, summed by
+// a walk of the bucket quadtree. The short-range pair force is the Newtonian
+// one times erfc(r / 2 r_s) + r / (r_s sqrt(pi)) exp(-r^2 / 4 r_s^2), which
+// has decayed below 2 % at the cutoff; nodes farther than the cutoff from a
+// body are never opened. Both parts add up to the full force, so bodies closer
+// than a few cells keep their exact interaction unlike plain PM.
+class TreePmSimulation{
+public:
+    static constexpr std::int32_t default_grid_size = 256;
+    // split radius r_s in cells of the mesh
+    static constexpr double default_split_cells = 1.25;
+    // cutoff of the short-range walk in split radii
+    static constexpr double default_cutoff_splits = 4.5;
+    // opening angle of the short-range walk, accepted nodes act as monopoles
+    static constexpr double default_threshold_theta = 0.5;
+    static constexpr std::int32_t default_leaf_capacity = 16;
+
+    static void simulate_epochs(Plotter& plotter, Universe& universe, std::uint32_t num_epochs, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size = default_grid_size);
+    static void simulate_epoch(Plotter& plotter, Universe& universe, bool create_intermediate_plots, std::uint32_t plot_intermediate_epochs, std::int32_t grid_size = default_grid_size);
+    static void calculate_forces(Universe& universe, Quadtree& quadtree, std::int32_t grid_size = default_grid_size, double threshold_theta = default_threshold_theta);
+    // only the short-range part, added onto universe.forces
+    static void add_short_range_forces(Universe& universe, Quadtree& quadtree, double split_radius, double cutoff_radius, double threshold_theta);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Minimal allocator that places every allocation on an Alignment-byte boundary.
+// Used for the structure-of-arrays body columns so that each column starts on a
+// cache line and vector loads never straddle two lines.
+template <typename T, std::size_t Alignment = 64> class AlignedAllocator{
+public:
+    using value_type = T;
+
+    template <typename U> struct rebind{
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    [[nodiscard]] T* allocate(std::size_t count){
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, std::size_t) noexcept {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+// cache line aligned column
+template <typename T> using AlignedVector = std::vector<T, AlignedAllocator<T, 64>>;
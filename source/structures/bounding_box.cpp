@@ -1,4 +1,5 @@
 #include "structures/bounding_box.h"
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -12,6 +13,12 @@ double BoundingBox::get_diagonal(){
     return std::max(1.0, sqrt(pow((x_max-x_min), 2) + pow((y_max-y_min), 2)));
 }
 
+double BoundingBox::get_distance(Vector2d<double> position) const {
+    double dx = std::max({x_min - position.x, 0.0, position.x - x_max});
+    double dy = std::max({y_min - position.y, 0.0, position.y - y_max});
+    return std::sqrt(dx * dx + dy * dy);
+}
+
 void BoundingBox::plotting_sanity_check(){
     // if one direction has a size of 0, convert to a square
     double x_size = x_max - x_min;
@@ -10,7 +10,7 @@ public:
     BoundingBox(double arg_x_min, double arg_x_max, double arg_y_min, double arg_y_max): x_min(arg_x_min), x_max(arg_x_max), y_min(arg_y_min), y_max(arg_y_max){}
 
     [[nodiscard]] bool contains(Vector2d<double> position){
-        if((x_min <= position[0]) && (position[0] <= x_max) && (y_min <= position[1]) && (position[1] <= y_max)){
+        if((x_min <= position.x) && (position.x <= x_max) && (y_min <= position.y) && (position.y <= y_max)){
             return true;
         }
         return false;
@@ -34,6 +34,8 @@ public:
 
     [[nodiscard]] std::string get_string();
     [[nodiscard]] double get_diagonal();
+    // distance from position to the closest point of the box, 0 inside the box
+    [[nodiscard]] double get_distance(Vector2d<double> position) const;
     void plotting_sanity_check();
     [[nodiscard]] BoundingBox get_scaled(std::uint32_t scaling_factor);
 
@@ -0,0 +1,33 @@
+#pragma once
+
+// Precision policies for the structure-of-arrays engine.
+//   storage_type:    type of the body columns (positions, velocities, weights)
+//   compute_type:    type of the pairwise distance / inverse cube arithmetic
+//   accumulate_type: type the per-body force sums are accumulated and stored in
+//
+// The pairwise arithmetic always runs on relative coordinates that are scaled
+// to the extent of the universe, so float compute does not underflow on
+// SI-unit inputs (r^3 of 1e15 m is below FLT_MIN).
+
+struct DoublePrecision{
+    using storage_type = double;
+    using compute_type = double;
+    using accumulate_type = double;
+};
+
+struct FloatPrecision{
+    using storage_type = float;
+    using compute_type = float;
+    using accumulate_type = float;
+};
+
+// Positions stay double so that the difference between two nearby bodies is
+// exact, the expensive inverse distance math runs in float and the sums are
+// accumulated in double. The positions are stored in the frame of the
+// universe; a mode with float positions relative to a tree node center would
+// need a tree engine on SoA columns, which does not exist.
+struct FloatComputePrecision{
+    using storage_type = double;
+    using compute_type = float;
+    using accumulate_type = double;
+};
@@ -28,9 +28,8 @@ BoundingBox Universe::get_bounding_box() {
     double y_max = std::numeric_limits<double>::min();;
 
     for (auto position : positions) {
-        double pos_x, pos_y;
-        pos_x = position[0];
-        pos_y = position[1];
+        double pos_x = position.x;
+        double pos_y = position.y;
 
         if (pos_x > x_max) {
             x_max = pos_x;
@@ -60,8 +59,8 @@ BoundingBox Universe::parallel_cpu_get_bounding_box() {
     // Parallele Schleife zur Berechnung der Bounding Box
 #pragma omp parallel for reduction(min: x_min, y_min) reduction(max: x_max, y_max)
     for (size_t i = 0; i < positions.size(); ++i) {
-        double pos_x = positions[i][0];
-        double pos_y = positions[i][1];
+        double pos_x = positions[i].x;
+        double pos_y = positions[i].y;
 
         // Berechnung der minimalen und maximalen x und y Koordinaten
         if (pos_x > x_max) {
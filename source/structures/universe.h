@@ -14,6 +14,7 @@ public:
     Universe(){
         num_bodies = 0;
         current_simulation_epoch = 0;
+        velocities_staggered = false;
     }
     void print_bodies_to_console();
     static Universe& get_instance() {
@@ -30,5 +31,7 @@ public:
     std::vector<Vector2d<double>> velocities;  // in m/s
     std::vector<Vector2d<double>> positions;  // in m
     std::uint32_t current_simulation_epoch;
+    // set by the leapfrog integrator: the velocities lead the positions by half an epoch
+    bool velocities_staggered;
 
 };
\ No newline at end of file
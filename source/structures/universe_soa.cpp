@@ -0,0 +1,79 @@
+#include "structures/universe_soa.h"
+
+#include <limits>
+#include <omp.h>
+
+template <typename Precision>
+BasicUniverseSoA<Precision>::BasicUniverseSoA(Universe& universe): BasicUniverseSoA(){
+    load_from(universe);
+}
+
+template <typename Precision>
+void BasicUniverseSoA<Precision>::resize(std::uint32_t bodies){
+    num_bodies = bodies;
+    weights.resize(bodies);
+    force_x.resize(bodies);
+    force_y.resize(bodies);
+    vel_x.resize(bodies);
+    vel_y.resize(bodies);
+    pos_x.resize(bodies);
+    pos_y.resize(bodies);
+}
+
+template <typename Precision>
+void BasicUniverseSoA<Precision>::load_from(Universe& universe){
+    resize(universe.num_bodies);
+    current_simulation_epoch = universe.current_simulation_epoch;
+
+#pragma omp parallel for
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(num_bodies); i++) {
+        weights[i] = static_cast<storage_type>(universe.weights[i]);
+        force_x[i] = static_cast<accumulate_type>(universe.forces[i].x);
+        force_y[i] = static_cast<accumulate_type>(universe.forces[i].y);
+        vel_x[i] = static_cast<storage_type>(universe.velocities[i].x);
+        vel_y[i] = static_cast<storage_type>(universe.velocities[i].y);
+        pos_x[i] = static_cast<storage_type>(universe.positions[i].x);
+        pos_y[i] = static_cast<storage_type>(universe.positions[i].y);
+    }
+}
+
+template <typename Precision>
+void BasicUniverseSoA<Precision>::store_to(Universe& universe){
+    universe.num_bodies = num_bodies;
+    universe.current_simulation_epoch = current_simulation_epoch;
+    universe.weights.resize(num_bodies);
+    universe.forces.resize(num_bodies);
+    universe.velocities.resize(num_bodies);
+    universe.positions.resize(num_bodies);
+
+#pragma omp parallel for
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(num_bodies); i++) {
+        universe.weights[i] = weights[i];
+        universe.forces[i] = Vector2d<double>(force_x[i], force_y[i]);
+        universe.velocities[i] = Vector2d<double>(vel_x[i], vel_y[i]);
+        universe.positions[i] = Vector2d<double>(pos_x[i], pos_y[i]);
+    }
+}
+
+template <typename Precision>
+BoundingBox BasicUniverseSoA<Precision>::get_bounding_box(){
+    storage_type x_min = std::numeric_limits<storage_type>::max();
+    storage_type x_max = std::numeric_limits<storage_type>::lowest();
+    storage_type y_min = std::numeric_limits<storage_type>::max();
+    storage_type y_max = std::numeric_limits<storage_type>::lowest();
+
+    // separate columns reduce to plain min/max sweeps that the compiler vectorizes
+#pragma omp parallel for simd reduction(min: x_min, y_min) reduction(max: x_max, y_max)
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(num_bodies); i++) {
+        x_min = pos_x[i] < x_min ? pos_x[i] : x_min;
+        x_max = pos_x[i] > x_max ? pos_x[i] : x_max;
+        y_min = pos_y[i] < y_min ? pos_y[i] : y_min;
+        y_max = pos_y[i] > y_max ? pos_y[i] : y_max;
+    }
+
+    return BoundingBox(x_min, x_max, y_min, y_max);
+}
+
+template class BasicUniverseSoA<DoublePrecision>;
+template class BasicUniverseSoA<FloatPrecision>;
+template class BasicUniverseSoA<FloatComputePrecision>;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+#include "structures/aligned_allocator.h"
+#include "structures/precision.h"
+#include "structures/vector2d.h"
+#include "structures/bounding_box.h"
+#include "structures/universe.h"
+
+// Read/write view over a pair of x/y columns that hands out Vector2d values.
+// Allows code written against Universe (positions[i][0], ...) to read a
+// UniverseSoA without knowing about the split layout.
+template <typename T> class Vector2dColumnView{
+public:
+    Vector2dColumnView(AlignedVector<T>& arg_x, AlignedVector<T>& arg_y): column_x(arg_x), column_y(arg_y){}
+
+    Vector2d<T> operator[](std::uint32_t index) const {
+        return Vector2d<T>(column_x[index], column_y[index]);
+    }
+
+    void set(std::uint32_t index, Vector2d<T> value){
+        column_x[index] = value.x;
+        column_y[index] = value.y;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return column_x.size();
+    }
+
+private:
+    AlignedVector<T>& column_x;
+    AlignedVector<T>& column_y;
+};
+
+// Structure-of-arrays body storage. Every component lives in its own 64-byte
+// aligned column so that the force and integration kernels stream through
+// contiguous scalars instead of strided Vector2d objects. The column types are
+// selected by a precision policy from structures/precision.h.
+//
+// Only NaiveParallelSimulation has SoA kernels. BarnesHutSimulation and the
+// Quadtree construction keep working on Universe: since Vector2d is a plain
+// x/y pair their body accesses are direct loads, and the tree walk is bound
+// by node loads rather than by the body layout.
+template <typename Precision> class BasicUniverseSoA{
+public:
+    using precision = Precision;
+    using storage_type = typename Precision::storage_type;
+    using accumulate_type = typename Precision::accumulate_type;
+
+    BasicUniverseSoA(){
+        num_bodies = 0;
+        current_simulation_epoch = 0;
+    }
+    explicit BasicUniverseSoA(Universe& universe);
+
+    void resize(std::uint32_t bodies);
+    void load_from(Universe& universe);
+    void store_to(Universe& universe);
+
+    BoundingBox get_bounding_box();
+
+    Vector2dColumnView<storage_type> positions(){
+        return Vector2dColumnView<storage_type>(pos_x, pos_y);
+    }
+    Vector2dColumnView<storage_type> velocities(){
+        return Vector2dColumnView<storage_type>(vel_x, vel_y);
+    }
+    Vector2dColumnView<accumulate_type> forces(){
+        return Vector2dColumnView<accumulate_type>(force_x, force_y);
+    }
+
+    std::uint32_t num_bodies;
+    AlignedVector<storage_type> weights;  // in kg
+    AlignedVector<accumulate_type> force_x, force_y;  // in N
+    AlignedVector<storage_type> vel_x, vel_y;  // in m/s
+    AlignedVector<storage_type> pos_x, pos_y;  // in m
+    std::uint32_t current_simulation_epoch;
+};
+
+using UniverseSoA = BasicUniverseSoA<DoublePrecision>;
+using UniverseSoAFloat = BasicUniverseSoA<FloatPrecision>;
+using UniverseSoAFloatCompute = BasicUniverseSoA<FloatComputePrecision>;
@@ -1,55 +1,98 @@
 #pragma once
 
-#include <stdexcept>
-#include <tuple>
 #include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 
+// Plain two component vector. Trivially copyable and free of branches or
+// exceptions so that loops over Vector2d values can be inlined and vectorized.
+// operator[] checks its index and throws; hot loops read the x and y members.
 template <typename T> class Vector2d{
 public:
 
-    Vector2d(){
-        contents = std::tuple<T, T>{T(), T()};
+    constexpr Vector2d() noexcept : x(T()), y(T()) {}
+
+    constexpr Vector2d(T arg_first, T arg_second) noexcept : x(arg_first), y(arg_second) {}
+
+    constexpr void set(T arg_first, T arg_second) noexcept {
+        x = arg_first;
+        y = arg_second;
+    }
+
+    constexpr bool operator==(const Vector2d& other) const noexcept {
+        return (x == other.x) && (y == other.y);
+    }
+
+    constexpr Vector2d operator+(const Vector2d& other) const noexcept {
+        return Vector2d(x + other.x, y + other.y);
+    }
+
+    constexpr Vector2d operator-(const Vector2d& other) const noexcept {
+        return Vector2d(x - other.x, y - other.y);
+    }
+
+    constexpr Vector2d operator-() const noexcept {
+        return Vector2d(-x, -y);
     }
 
-    Vector2d(T arg_first, T arg_second){
-        contents = std::tuple<T, T>{arg_first, arg_second};
+    constexpr Vector2d operator*(T scalar) const noexcept {
+        return Vector2d(x * scalar, y * scalar);
     }
 
-    void set(T arg_first, T arg_second){
-        std::get<0>(contents) = arg_first;
-        std::get<1>(contents) = arg_second;
+    constexpr Vector2d operator/(T scalar) const noexcept {
+        return Vector2d(x / scalar, y / scalar);
     }
 
-    bool operator==(Vector2d other) const {
-        return (std::get<0>(contents) == other[0]) && (std::get<1>(contents) == other[1]);
+    constexpr Vector2d& operator+=(const Vector2d& other) noexcept {
+        x += other.x;
+        y += other.y;
+        return *this;
     }
 
-    Vector2d operator+(Vector2d other) const {
-        return Vector2d(std::get<0>(contents) + other[0], std::get<1>(contents) + other[1]);
+    constexpr Vector2d& operator-=(const Vector2d& other) noexcept {
+        x -= other.x;
+        y -= other.y;
+        return *this;
     }
 
-    Vector2d operator-(Vector2d other) const {
-        return Vector2d(std::get<0>(contents) - other[0], std::get<1>(contents) - other[1]);
+    constexpr Vector2d& operator*=(T scalar) noexcept {
+        x *= scalar;
+        y *= scalar;
+        return *this;
     }
 
-    Vector2d operator*(T scalar) const {
-        return Vector2d(std::get<0>(contents) * scalar, std::get<1>(contents) * scalar);
+    [[nodiscard]] constexpr T dot(const Vector2d& other) const noexcept {
+        return x * other.x + y * other.y;
     }
 
-    Vector2d operator/(T scalar) const {
-        return Vector2d(std::get<0>(contents) / scalar, std::get<1>(contents) / scalar);
+    // squared euclidean length, avoids the sqrt where only comparisons are needed
+    [[nodiscard]] constexpr T norm2() const noexcept {
+        return x * x + y * y;
     }
 
-    T operator[](std::int32_t position) const {
-        if (position == 0){
-            return std::get<0>(contents);
+    constexpr T operator[](std::int32_t position) const {
+        if (position == 0) {
+            return x;
         }
-        if (position == 1){
-            return std::get<1>(contents);
+        if (position == 1) {
+            return y;
         }
         throw std::invalid_argument("Out of bounds access to Vector2d");
     }
 
-private:
-    std::tuple<T, T> contents;
-};
\ No newline at end of file
+    constexpr T& operator[](std::int32_t position) {
+        if (position == 0) {
+            return x;
+        }
+        if (position == 1) {
+            return y;
+        }
+        throw std::invalid_argument("Out of bounds access to Vector2d");
+    }
+
+    T x;
+    T y;
+};
+
+static_assert(std::is_trivially_copyable_v<Vector2d<double>>, "Vector2d must stay trivially copyable");
+static_assert(sizeof(Vector2d<double>) == 2 * sizeof(double), "Vector2d must not carry padding");
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+// In-place iterative radix-2 FFT over data[0], data[stride], ..., data[(size - 1) * stride].
+// size must be a power of two. The inverse transform is not normalized.
+static void fft(std::complex<double>* data, std::int64_t size, std::int64_t stride, bool inverse){
+    // bit reversal permutation
+    for(std::int64_t i = 1, j = 0; i < size; i++){
+        std::int64_t bit = size >> 1;
+        for(; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j){
+            std::swap(data[i * stride], data[j * stride]);
+        }
+    }
+
+    // butterflies, the twiddle factors of a stage are built by one recurrence
+    const double sign = inverse ? 1.0 : -1.0;
+    for(std::int64_t length = 2; length <= size; length <<= 1){
+        const double angle = sign * 2.0 * std::numbers::pi / static_cast<double>(length);
+        const std::complex<double> step(std::cos(angle), std::sin(angle));
+        const std::int64_t half = length / 2;
+        for(std::int64_t start = 0; start < size; start += length){
+            std::complex<double> twiddle(1.0, 0.0);
+            for(std::int64_t k = 0; k < half; k++){
+                std::complex<double>& even = data[(start + k) * stride];
+                std::complex<double>& odd = data[(start + k + half) * stride];
+                const std::complex<double> product = odd * twiddle;
+                odd = even - product;
+                even += product;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+// 2D FFT of a row-major size x size grid, rows and columns are transformed in parallel.
+// Columns are copied into a contiguous buffer first, strided butterflies would
+// touch a new cache line for every element.
+static void fft_2d(std::vector<std::complex<double>>& grid, std::int64_t size, bool inverse){
+#pragma omp parallel
+    {
+#pragma omp for schedule(static)
+        for(std::int64_t row = 0; row < size; row++){
+            fft(grid.data() + row * size, size, 1, inverse);
+        }
+
+        std::vector<std::complex<double>> column(size);
+#pragma omp for schedule(static)
+        for(std::int64_t col = 0; col < size; col++){
+            for(std::int64_t row = 0; row < size; row++){
+                column[row] = grid[row * size + col];
+            }
+            fft(column.data(), size, 1, inverse);
+            for(std::int64_t row = 0; row < size; row++){
+                grid[row * size + col] = column[row];
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "test.h"
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+
+#include "structures/universe.h"
+#include "structures/bounding_box.h"
+#include "physics/gravitation.h"
+#include "plotting/plotter.h"
+
+#include "simulation/constants.h"
+#include "simulation/integrator.h"
+
+/**
+ * @brief Fixture for tests that change the global integration scheme or the
+ * epoch length, both are restored after every test. Holds a plotter for the
+ * simulate_epoch interfaces, which only use it for intermediate plots.
+ */
+class IntegrationTest : public LabTest {
+protected:
+    void TearDown() override {
+        integration_scheme = IntegrationScheme::symplectic_euler;
+        epoch_in_seconds = default_epoch_in_seconds;
+    }
+
+    const double default_epoch_in_seconds = epoch_in_seconds;
+
+    BoundingBox plot_bb = BoundingBox(-5, 5, -5, 5);
+    Plotter plotter = Plotter(plot_bb, std::filesystem::path{"dummy_plot"}, 10, 10);
+};
+
+/**
+ * @brief Sun and a planet on an eccentric orbit with its aphelion at 1 AU
+ *
+ * @param velocity_fraction aphelion velocity relative to the circular velocity,
+ * smaller values give more eccentric orbits
+ * @return Universe universe with two bodies
+ */
+[[nodiscard]] inline Universe create_eccentric_orbit(double velocity_fraction){
+    Universe uni;
+    const double sun_mass = 1.989e30;
+    const double distance = 1.496e11;
+    const double circular_velocity = std::sqrt(gravitational_constant * sun_mass / distance);
+    uni.positions = {{0.0, 0.0}, {distance, 0.0}};
+    uni.weights = {sun_mass, 5.972e24};
+    uni.velocities = {{0.0, 0.0}, {0.0, velocity_fraction * circular_velocity}};
+    uni.forces = {{0.0, 0.0}, {0.0, 0.0}};
+    uni.num_bodies = 2;
+    return uni;
+}
+
+/**
+ * @brief Kinetic plus potential energy of all bodies
+ *
+ * @param uni universe
+ * @return double energy in J
+ */
+[[nodiscard]] inline double total_energy(Universe& uni){
+    double energy = 0.0;
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        energy += 0.5 * uni.weights[i] * uni.velocities[i].norm2();
+        for(std::uint32_t j = i + 1; j < uni.num_bodies; j++){
+            energy -= gravitational_constant * uni.weights[i] * uni.weights[j] / std::sqrt((uni.positions[i] - uni.positions[j]).norm2());
+        }
+    }
+    return energy;
+}
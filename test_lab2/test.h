@@ -2,7 +2,13 @@
 
 #include "gtest/gtest.h"
 
+#include <cmath>
+#include <cstdint>
 #include <filesystem>
+#include <random>
+
+#include "structures/universe.h"
+#include "physics/gravitation.h"
 
 /**
  * @brief Get the path to the inputs
@@ -15,3 +21,68 @@ class LabTest : public ::testing::Test {
 
 };
 
+
+/**
+ * @brief Random universe with the mass and position ranges of
+ * InputGenerator::create_random_universe, but drawn from a fixed seed so that
+ * the same bodies are used in every run
+ *
+ * @param bodies number of bodies
+ * @param seed seed of the generator
+ * @return Universe universe at rest
+ */
+[[nodiscard]] inline Universe create_seeded_universe(std::uint32_t bodies, std::uint32_t seed = 42){
+    Universe uni;
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> mantissa(0.0, 1.0);
+    std::uniform_int_distribution<int> exponent(23, 35);
+    std::uniform_real_distribution<double> position(-9.46e14, 9.46e14);
+    for(std::uint32_t i = 0; i < bodies; i++){
+        uni.weights.push_back(mantissa(generator) * std::pow(10.0, exponent(generator)));
+        uni.positions.emplace_back(position(generator), position(generator));
+    }
+    uni.velocities.assign(bodies, Vector2d<double>(0.0, 0.0));
+    uni.forces.assign(bodies, Vector2d<double>(0.0, 0.0));
+    uni.num_bodies = bodies;
+    return uni;
+}
+
+/**
+ * @brief Sum of the Newtonian pair force magnitudes on body i, each weighted
+ * with 1 + extent / r_ij. The net force may cancel almost completely, so
+ * kernels that only differ in rounding are compared against this sum instead
+ * of against the force itself.
+ *
+ * @param uni universe
+ * @param i body index
+ * @param extent length scale of the position rounding, 0 for the plain sum
+ * @return double force scale in N
+ */
+[[nodiscard]] inline double pair_force_scale(Universe& uni, std::uint32_t i, double extent = 0.0){
+    double scale = 0.0;
+    for(std::uint32_t j = 0; j < uni.num_bodies; j++){
+        double distance_squared = (uni.positions[i] - uni.positions[j]).norm2();
+        if(distance_squared > 0.0){
+            double pair_force = gravitational_constant * uni.weights[i] * uni.weights[j] / distance_squared;
+            scale += pair_force * (1.0 + extent / std::sqrt(distance_squared));
+        }
+    }
+    return scale;
+}
+
+/**
+ * @brief Relative L1 error of the forces of uni against the reference forces
+ *
+ * @param uni universe with the forces to check
+ * @param reference universe with the reference forces
+ * @return double relative error, not finite if a force is not finite
+ */
+[[nodiscard]] inline double relative_force_error(Universe& uni, Universe& reference){
+    double error = 0.0;
+    double norm = 0.0;
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        error += std::sqrt((uni.forces[i] - reference.forces[i]).norm2());
+        norm += std::sqrt(reference.forces[i].norm2());
+    }
+    return error / norm;
+}
@@ -0,0 +1,163 @@
+#include "test.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "quadtree/quadtree.h"
+
+#include "simulation/barnes_hut_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class BarnesHutTest : public LabTest, public ::testing::WithParamInterface<std::int32_t> {};
+
+TEST_P(BarnesHutTest, test_forces_match_naive){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, GetParam());
+    qt.calculate_cumulative_masses();
+    qt.calculate_center_of_mass();
+    BarnesHutSimulation::calculate_forces(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-2);
+}
+
+TEST_F(BarnesHutTest, test_bucket_covers_all_bodies){
+    // with buckets as large as the universe every quadrant of the root is a
+    // leaf, so the force pass reduces to the exact all-pairs sum
+    Universe uni;
+    InputGenerator::create_random_universe(64, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, 64);
+    qt.calculate_cumulative_masses();
+    qt.calculate_center_of_mass();
+    for(auto child: qt.root->children){
+        ASSERT_TRUE(child->children.empty());
+    }
+    BarnesHutSimulation::calculate_forces(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-12);
+}
+
+TEST_F(BarnesHutTest, test_forces_after_update){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+
+    // one epoch of motion, the tree is refitted instead of rebuilt
+    NaiveParallelSimulation::calculate_forces(uni);
+    NaiveParallelSimulation::calculate_velocities(uni);
+    NaiveParallelSimulation::calculate_positions(uni);
+    ASSERT_FALSE(qt.update(uni, 1.0));
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+    BarnesHutSimulation::calculate_forces(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-2);
+}
+
+TEST_F(BarnesHutTest, test_quadrupole){
+    // the comparison across theta holds for typical universes, not for every
+    // random draw, so the bodies come from a fixed seed
+    Universe uni = create_seeded_universe(2000);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+    auto error_for = [&](double threshold_theta, bool use_quadrupole){
+        BarnesHutSimulation::calculate_forces(uni, qt, threshold_theta, use_quadrupole);
+        return relative_force_error(uni, reference);
+    };
+
+    // the quadrupole term improves every theta, at 0.3 it beats the monopole at 0.2
+    for(double threshold_theta : {0.2, 0.5, 0.7}){
+        ASSERT_LT(error_for(threshold_theta, true), error_for(threshold_theta, false));
+    }
+    ASSERT_LT(error_for(BarnesHutSimulation::default_threshold_theta, true), error_for(0.2, false));
+}
+
+TEST_P(BarnesHutTest, test_dual_tree_matches_naive){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    // the cell-wide acceptance is at least as strict as the per-body one
+    Quadtree qt(uni, uni.get_bounding_box(), 2, GetParam());
+    BarnesHutSimulation::calculate_forces_dual_tree(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-2);
+}
+
+TEST_F(BarnesHutTest, test_streaming_matches_interaction_lists){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+
+    Universe streamed = uni;
+    BarnesHutSimulation::calculate_forces(streamed, qt, BarnesHutSimulation::default_threshold_theta, true);
+
+    std::vector<std::vector<QuadtreeNode*>> interaction_lists;
+    BarnesHutSimulation::calculate_forces_with_interaction_lists(uni, qt, BarnesHutSimulation::default_threshold_theta, true, interaction_lists);
+    ASSERT_EQ(interaction_lists.size(), uni.num_bodies);
+
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        // the exported nodes hold every body once, K's own leaf included
+        double covered_mass = 0.0;
+        for(auto* node : interaction_lists[i]){
+            covered_mass += node->cumulative_mass;
+        }
+        ASSERT_NEAR(covered_mass, qt.root->cumulative_mass, qt.root->cumulative_mass * 1e-12 + uni.weights[i]);
+        ASSERT_NEAR(streamed.forces[i].x, uni.forces[i].x, 1e-9 * std::sqrt(uni.forces[i].norm2()));
+        ASSERT_NEAR(streamed.forces[i].y, uni.forces[i].y, 1e-9 * std::sqrt(uni.forces[i].norm2()));
+    }
+}
+
+TEST_P(BarnesHutTest, test_grouped_matches_naive){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, GetParam());
+    BarnesHutSimulation::calculate_forces_grouped(uni, qt, BarnesHutSimulation::default_threshold_theta, false);
+    double monopole_error = relative_force_error(uni, reference);
+    ASSERT_LT(monopole_error, 1e-2);
+
+    // the vectorized quadrupole term improves on the monopole
+    BarnesHutSimulation::calculate_forces_grouped(uni, qt);
+    ASSERT_LT(relative_force_error(uni, reference), monopole_error);
+}
+
+TEST_P(BarnesHutTest, test_grouped_kernels_match_scalar){
+    Universe uni = create_seeded_universe(2000);
+    Quadtree qt(uni, uni.get_bounding_box(), 2, GetParam());
+
+    Universe reference = uni;
+    BarnesHutSimulation::calculate_forces_grouped(reference, qt, NaiveSimdSimulation::Kernel::scalar);
+
+    // the wide kernels reassociate the sums of the same list
+    for (NaiveSimdSimulation::Kernel kernel : {NaiveSimdSimulation::Kernel::avx2, NaiveSimdSimulation::Kernel::avx512}) {
+        if (!NaiveSimdSimulation::is_supported(kernel)) {
+            ASSERT_THROW(BarnesHutSimulation::calculate_forces_grouped(uni, qt, kernel), std::invalid_argument);
+            continue;
+        }
+        BarnesHutSimulation::calculate_forces_grouped(uni, qt, kernel);
+        ASSERT_LT(relative_force_error(uni, reference), 1e-12);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(LeafCapacities, BarnesHutTest, ::testing::Values(1, 8, 16, 64));
@@ -0,0 +1,101 @@
+#include "integration_test.h"
+
+#include <cmath>
+#include <numbers>
+#include <random>
+
+#include "structures/universe.h"
+#include "physics/gravitation.h"
+
+#include "simulation/block_timestep_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class BlockTimestepTest : public IntegrationTest {};
+
+// light bodies on circular orbits around a supermassive black hole, the
+// innermost orbits take a few epochs, the outermost thousands
+static Universe create_black_hole_system(std::uint32_t bodies){
+    Universe uni;
+    const double black_hole_mass = 8.54e36;
+    uni.positions = {{0.0, 0.0}};
+    uni.velocities = {{0.0, 0.0}};
+    uni.weights = {black_hole_mass};
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> log_radius(std::log(2.0e13), std::log(1.0e15));
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * std::numbers::pi);
+    for(std::uint32_t i = 1; i < bodies; i++){
+        double r = std::exp(log_radius(generator));
+        double phi = angle(generator);
+        double v = std::sqrt(gravitational_constant * black_hole_mass / r);
+        uni.positions.emplace_back(r * std::cos(phi), r * std::sin(phi));
+        uni.velocities.emplace_back(-v * std::sin(phi), v * std::cos(phi));
+        uni.weights.push_back(1.0e24);
+    }
+    uni.forces.assign(bodies, Vector2d<double>(0.0, 0.0));
+    uni.num_bodies = bodies;
+    return uni;
+}
+
+TEST_F(BlockTimestepTest, test_calculate_rung){
+    const double length_scale = 1.0e12;
+    const double accuracy = 0.05;
+    // acceleration that exactly allows one epoch
+    const double limit = accuracy * accuracy * length_scale / (epoch_in_seconds * epoch_in_seconds);
+
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(0.0, length_scale, accuracy, 8), 0);
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(limit, length_scale, accuracy, 8), 0);
+    // half the step tolerates four times the acceleration
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(1.01 * limit, length_scale, accuracy, 8), 1);
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(4.0 * limit, length_scale, accuracy, 8), 1);
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(4.01 * limit, length_scale, accuracy, 8), 2);
+    ASSERT_EQ(BlockTimestepSimulation::calculate_rung(1.0e30 * limit, length_scale, accuracy, 8), 8);
+}
+
+TEST_F(BlockTimestepTest, test_single_rung_matches_leapfrog){
+    // few bodies share one leaf, so the tree forces are exact
+    Universe uni = create_black_hole_system(8);
+    Universe reference = uni;
+
+    BlockTimestepSimulation::simulate_epochs(plotter, uni, 5, false, 1, 0);
+
+    integration_scheme = IntegrationScheme::leapfrog;
+    for(int epoch = 0; epoch < 5; epoch++){
+        NaiveParallelSimulation::calculate_forces(reference);
+        Integrator::step(reference);
+    }
+    NaiveParallelSimulation::calculate_forces(reference);
+    Integrator::synchronize_velocities(reference);
+
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        ASSERT_NEAR(uni.positions[i].x, reference.positions[i].x, 1e-9 * std::sqrt(reference.positions[i].norm2()) + 1.0);
+        ASSERT_NEAR(uni.positions[i].y, reference.positions[i].y, 1e-9 * std::sqrt(reference.positions[i].norm2()) + 1.0);
+        ASSERT_NEAR(uni.velocities[i].x, reference.velocities[i].x, 1e-9 * std::sqrt(reference.velocities[i].norm2()) + 1e-9);
+        ASSERT_NEAR(uni.velocities[i].y, reference.velocities[i].y, 1e-9 * std::sqrt(reference.velocities[i].norm2()) + 1e-9);
+    }
+}
+
+TEST_F(BlockTimestepTest, test_black_hole_orbits){
+    const std::uint32_t num_epochs = 10;
+    const std::int32_t max_rung = 6;
+
+    Universe shared = create_black_hole_system(300);
+    Universe block = shared;
+    const double initial_energy = total_energy(shared);
+
+    // everybody on the epoch
+    BlockTimestepSimulation::simulate_epochs(plotter, shared, num_epochs, false, 1, 0);
+    double shared_error = std::abs((total_energy(shared) - initial_energy) / initial_energy);
+
+    std::uint64_t force_evaluations = 0;
+    BlockTimestepSimulation::simulate_epochs(plotter, block, 0, false, 1, max_rung);
+    for(std::uint32_t epoch = 0; epoch < num_epochs; epoch++){
+        force_evaluations += BlockTimestepSimulation::simulate_epoch(plotter, block, false, 1, max_rung);
+    }
+    double block_error = std::abs((total_energy(block) - initial_energy) / initial_energy);
+
+    ASSERT_LT(block_error, 0.1 * shared_error);
+    // far fewer than with every body on the deepest rung
+    ASSERT_LT(force_evaluations, 300ull * num_epochs * (1ull << max_rung) / 4);
+    ASSERT_EQ(block.current_simulation_epoch, num_epochs);
+}
@@ -0,0 +1,57 @@
+#include "test.h"
+
+#include <cmath>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "quadtree/quadtree.h"
+
+#include "simulation/fmm_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class FmmTest : public LabTest {};
+
+TEST_F(FmmTest, test_forces_match_naive){
+    Universe uni;
+    InputGenerator::create_random_universe(3000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, FmmSimulation::default_leaf_capacity);
+    FmmSimulation::calculate_forces(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-3);
+}
+
+TEST_F(FmmTest, test_error_decreases_with_order){
+    Universe uni;
+    InputGenerator::create_random_universe(3000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, FmmSimulation::default_leaf_capacity);
+    double previous_error = 1.0;
+    for(std::int32_t order : {2, 4, 6, 8}){
+        FmmSimulation::calculate_forces(uni, qt, order);
+        double error = relative_force_error(uni, reference);
+        ASSERT_LT(error, previous_error);
+        previous_error = error;
+    }
+}
+
+TEST_F(FmmTest, test_leaves_only){
+    // a single leaf holding every body: the walk is one all-pairs P2P
+    Universe uni;
+    InputGenerator::create_random_universe(50, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, 64);
+    FmmSimulation::calculate_forces(uni, qt);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-12);
+}
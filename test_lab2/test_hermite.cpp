@@ -0,0 +1,99 @@
+#include "integration_test.h"
+
+#include <cmath>
+#include <numeric>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+#include "physics/gravitation.h"
+
+#include "simulation/hermite_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class HermiteTest : public IntegrationTest {};
+
+TEST_F(HermiteTest, test_accelerations_and_jerks){
+    Universe uni;
+    InputGenerator::create_random_universe(200, uni);
+    std::vector<std::int32_t> everybody(uni.num_bodies);
+    std::iota(everybody.begin(), everybody.end(), 0);
+
+    std::vector<Vector2d<double>> accelerations(uni.num_bodies), jerks(uni.num_bodies);
+    HermiteSimulation::calculate_accelerations_and_jerks(uni, uni.positions, uni.velocities, everybody, accelerations, jerks);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    // the jerk is the derivative of the acceleration along the motion
+    const double h = 1.0e3;
+    std::vector<Vector2d<double>> forward(uni.positions.size()), backward(uni.positions.size());
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        forward[i] = uni.positions[i] + uni.velocities[i] * h;
+        backward[i] = uni.positions[i] - uni.velocities[i] * h;
+    }
+    std::vector<Vector2d<double>> forward_accelerations(uni.num_bodies), backward_accelerations(uni.num_bodies), unused(uni.num_bodies);
+    HermiteSimulation::calculate_accelerations_and_jerks(uni, forward, uni.velocities, everybody, forward_accelerations, unused);
+    HermiteSimulation::calculate_accelerations_and_jerks(uni, backward, uni.velocities, everybody, backward_accelerations, unused);
+
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        Vector2d<double> force = accelerations[i] * uni.weights[i];
+        double force_norm = std::sqrt(reference.forces[i].norm2());
+        ASSERT_NEAR(force.x, reference.forces[i].x, force_norm * 1e-9);
+        ASSERT_NEAR(force.y, reference.forces[i].y, force_norm * 1e-9);
+
+        Vector2d<double> difference = (forward_accelerations[i] - backward_accelerations[i]) / (2.0 * h);
+        double jerk_norm = std::sqrt(jerks[i].norm2());
+        ASSERT_NEAR(difference.x, jerks[i].x, jerk_norm * 1e-4);
+        ASSERT_NEAR(difference.y, jerks[i].y, jerk_norm * 1e-4);
+    }
+}
+
+TEST_F(HermiteTest, test_fourth_order){
+    // a quarter of eta halves the steps and cuts the error about sixteen times
+    double errors[2];
+    for(int run = 0; run < 2; run++){
+        Universe uni = create_eccentric_orbit(0.5);
+        const double initial_energy = total_energy(uni);
+        HermiteSimulation::State state;
+        HermiteSimulation::initialize(uni, state);
+        for(std::uint32_t epoch = 0; epoch < 12; epoch++){
+            HermiteSimulation::simulate_epoch(plotter, uni, state, false, 1, run == 0 ? 0.02 : 0.005);
+        }
+        errors[run] = std::abs((total_energy(uni) - initial_energy) / initial_energy);
+    }
+    ASSERT_LT(errors[1], errors[0] / 10.0);
+}
+
+TEST_F(HermiteTest, test_eccentric_orbit){
+    // one year, several orbits of the planet, with a tighter accuracy than the default
+    const std::uint32_t num_epochs = 12;
+    const double accuracy = 0.005;
+
+    Universe hermite = create_eccentric_orbit(0.5);
+    const double initial_energy = total_energy(hermite);
+    HermiteSimulation::State state;
+    HermiteSimulation::initialize(hermite, state);
+    std::uint64_t force_evaluations = 0;
+    for(std::uint32_t epoch = 0; epoch < num_epochs; epoch++){
+        force_evaluations += HermiteSimulation::simulate_epoch(plotter, hermite, state, false, 1, accuracy);
+    }
+    double hermite_error = std::abs((total_energy(hermite) - initial_energy) / initial_energy);
+
+    // leapfrog with as many force evaluations in equal steps, the epoch length
+    // is restored by the fixture
+    const std::uint64_t leapfrog_epochs = force_evaluations / 2;
+    epoch_in_seconds = default_epoch_in_seconds * num_epochs / static_cast<double>(leapfrog_epochs);
+    integration_scheme = IntegrationScheme::leapfrog;
+    Universe leapfrog = create_eccentric_orbit(0.5);
+    for(std::uint64_t step = 0; step < leapfrog_epochs; step++){
+        NaiveParallelSimulation::calculate_forces(leapfrog);
+        Integrator::step(leapfrog);
+    }
+    NaiveParallelSimulation::calculate_forces(leapfrog);
+    Integrator::synchronize_velocities(leapfrog);
+    double leapfrog_error = std::abs((total_energy(leapfrog) - initial_energy) / initial_energy);
+
+    ASSERT_LT(hermite_error, 1e-6);
+    ASSERT_LT(hermite_error, 0.1 * leapfrog_error);
+    ASSERT_EQ(hermite.current_simulation_epoch, num_epochs);
+}
@@ -0,0 +1,70 @@
+#include "integration_test.h"
+
+#include <cmath>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "simulation/naive_parallel_simulation.h"
+
+class IntegratorTest : public IntegrationTest {};
+
+// relative energy error after simulating the given time with the given epoch length
+static double energy_error(double epoch_length, double duration){
+    epoch_in_seconds = epoch_length;
+    Universe uni = create_eccentric_orbit(0.7);
+    const double initial_energy = total_energy(uni);
+
+    const auto num_epochs = static_cast<std::uint32_t>(duration / epoch_length);
+    for(std::uint32_t epoch = 0; epoch < num_epochs; epoch++){
+        NaiveParallelSimulation::calculate_forces(uni);
+        Integrator::step(uni);
+    }
+    NaiveParallelSimulation::calculate_forces(uni);
+    Integrator::synchronize_velocities(uni);
+    EXPECT_FALSE(uni.velocities_staggered);
+
+    return std::abs((total_energy(uni) - initial_energy) / initial_energy);
+}
+
+TEST_F(IntegratorTest, test_symplectic_euler_matches_separate_sweeps){
+    Universe uni;
+    InputGenerator::create_random_universe(500, uni);
+    NaiveParallelSimulation::calculate_forces(uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_velocities(reference);
+    NaiveParallelSimulation::calculate_positions(reference);
+    Integrator::step(uni);
+
+    ASSERT_FALSE(uni.velocities_staggered);
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        ASSERT_DOUBLE_EQ(uni.velocities[i].x, reference.velocities[i].x);
+        ASSERT_DOUBLE_EQ(uni.velocities[i].y, reference.velocities[i].y);
+        ASSERT_DOUBLE_EQ(uni.positions[i].x, reference.positions[i].x);
+        ASSERT_DOUBLE_EQ(uni.positions[i].y, reference.positions[i].y);
+    }
+}
+
+TEST_F(IntegratorTest, test_leapfrog_conserves_energy_with_larger_epochs){
+    const double day = 86400.0;
+    const double duration = 2.0 * 365.0 * day;
+
+    integration_scheme = IntegrationScheme::symplectic_euler;
+    double euler_error = energy_error(day, duration);
+
+    integration_scheme = IntegrationScheme::leapfrog;
+    double leapfrog_error = energy_error(4.0 * day, duration);
+
+    ASSERT_LT(leapfrog_error, euler_error);
+}
+
+TEST_F(IntegratorTest, test_leapfrog_is_second_order){
+    // halving the epoch reduces the energy error about four times
+    integration_scheme = IntegrationScheme::leapfrog;
+    const double day = 86400.0;
+    const double duration = 365.0 * day;
+    double coarse_error = energy_error(4.0 * day, duration);
+    double fine_error = energy_error(2.0 * day, duration);
+    ASSERT_LT(fine_error, 0.35 * coarse_error);
+}
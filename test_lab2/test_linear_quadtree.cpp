@@ -0,0 +1,105 @@
+#include "test.h"
+
+#include <exception>
+#include <iostream>
+#include <set>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+#include "utilities/import.hpp"
+
+#include "quadtree/linear_quadtree.h"
+#include "simulation/barnes_hut_simulation.h"
+
+class LinearQuadtreeTest : public LabTest {};
+
+TEST_F(LinearQuadtreeTest, test_structure){
+    Universe uni;
+    InputGenerator::create_random_universe(1000, uni);
+    LinearQuadtree qt(uni, uni.get_bounding_box());
+
+    std::set<std::int32_t> bodies;
+    for(std::uint32_t node_index = 0; node_index < qt.nodes.size(); node_index++){
+        const LinearQuadtreeNode& node = qt.nodes[node_index];
+        ASSERT_DOUBLE_EQ(node.size_squared, 8.0 * node.half_width * node.half_width);
+
+        if(node.is_leaf()){
+            // empty quadrants keep their slot as an empty leaf
+            if(node.is_empty()){
+                ASSERT_EQ(node.cumulative_mass, 0.0);
+                continue;
+            }
+            // center +- half width may round by an ulp at the edges of the universe
+            Vector2d<double> offset = uni.positions[node.body_identifier] - node.center;
+            ASSERT_LE(std::abs(offset.x), node.half_width * (1.0 + 1e-12));
+            ASSERT_LE(std::abs(offset.y), node.half_width * (1.0 + 1e-12));
+            bodies.insert(node.body_identifier);
+            continue;
+        }
+        ASSERT_EQ(node.body_identifier, -1);
+        // children follow their parent and split its cell into four quadrants
+        ASSERT_GT(node.first_child, static_cast<std::int32_t>(node_index));
+        for(std::int32_t child = node.first_child; child < node.first_child + LinearQuadtreeNode::child_count; child++){
+            const LinearQuadtreeNode& child_node = qt.nodes[child];
+            ASSERT_DOUBLE_EQ(child_node.half_width, node.half_width / 2.0);
+            ASSERT_NEAR(std::abs(child_node.center.x - node.center.x), child_node.half_width, node.half_width * 1e-12);
+            ASSERT_NEAR(std::abs(child_node.center.y - node.center.y), child_node.half_width, node.half_width * 1e-12);
+        }
+    }
+    // every body ends up in exactly one leaf
+    ASSERT_EQ(bodies.size(), uni.num_bodies);
+}
+
+TEST_F(LinearQuadtreeTest, test_center_of_mass){
+    Universe uni;
+    std::vector<Vector2d<double>> positions = {{100.0, 100.0}, {-100.0, -100.0}, {100.0, -100.0}, {-100.0, 100.0}};
+    std::vector<double> weights = {100.0, 100.0, 200.0, 100.0};
+    for(std::int32_t i = 0; i < 4; i++){
+        uni.forces.push_back(Vector2d<double>(0.0, 0.0));
+        uni.velocities.push_back(Vector2d<double>(0.0, 0.0));
+        uni.positions.push_back(positions[i]);
+        uni.weights.push_back(weights[i]);
+    }
+    uni.num_bodies = 4;
+
+    LinearQuadtree qt(uni, uni.get_bounding_box());
+    qt.calculate_cumulative_masses();
+    qt.calculate_center_of_mass();
+
+    const LinearQuadtreeNode& root = qt.nodes[LinearQuadtree::root];
+    for(std::int32_t child = root.first_child; child < root.first_child + LinearQuadtreeNode::child_count; child++){
+        ASSERT_NE(qt.nodes[child].body_identifier, -1);
+    }
+    ASSERT_DOUBLE_EQ(root.cumulative_mass, 500.0);
+    ASSERT_EQ(root.center_of_mass, Vector2d<double>(20.0, -20.0));
+}
+
+TEST_F(LinearQuadtreeTest, test_relevant_nodes){
+    Universe uni;
+    auto tmp = std::filesystem::path{"../test_input_grading/test_five_ppws24_D75C_universe.txt"};
+    load_universe(tmp, uni);
+
+    LinearQuadtree qt(uni, uni.get_bounding_box());
+    qt.calculate_center_of_mass();
+
+    double total_mass = 0.0;
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        total_mass += uni.weights[i];
+    }
+
+    std::int32_t body_index = 0;
+    auto body_position = uni.positions[body_index];
+    // the relevant nodes cover every body but K exactly once, fewer of them the larger theta
+    std::size_t previous_count = uni.num_bodies;
+    for(double threshold_theta : {0.1, 0.2, 0.3, 0.4}){
+        std::vector<std::int32_t> relevant_nodes;
+        BarnesHutSimulation::get_relevant_nodes(uni, qt, relevant_nodes, body_position, body_index, threshold_theta);
+        double covered_mass = 0.0;
+        for(auto node_index : relevant_nodes){
+            covered_mass += qt.nodes[node_index].cumulative_mass;
+        }
+        ASSERT_NEAR(covered_mass, total_mass - uni.weights[body_index], total_mass * 1e-12);
+        ASSERT_LE(relevant_nodes.size(), previous_count);
+        previous_count = relevant_nodes.size();
+    }
+}
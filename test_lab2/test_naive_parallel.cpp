@@ -0,0 +1,27 @@
+#include "test.h"
+
+#include <limits>
+
+#include "structures/universe.h"
+
+#include "simulation/naive_parallel_simulation.h"
+#include "simulation/naive_sequential_simulation.h"
+
+class NaiveParallelTest : public LabTest {};
+
+TEST_F(NaiveParallelTest, test_forces_match_sequential){
+    Universe uni = create_seeded_universe(1000);
+
+    Universe reference = uni;
+    NaiveSequentialSimulation::calculate_forces(reference);
+    NaiveParallelSimulation::calculate_forces(uni);
+
+    // each pair is evaluated once, the per-thread sums only change the
+    // summation order, which shifts the result by a few ulp of the pair forces
+    const double tolerance = 64.0 * std::numeric_limits<double>::epsilon();
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        double scale = pair_force_scale(uni, i);
+        ASSERT_NEAR(uni.forces[i].x, reference.forces[i].x, scale * tolerance);
+        ASSERT_NEAR(uni.forces[i].y, reference.forces[i].y, scale * tolerance);
+    }
+}
@@ -0,0 +1,69 @@
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "structures/universe.h"
+
+#include "simulation/naive_simd_simulation.h"
+#include "simulation/naive_sequential_simulation.h"
+
+class NaiveSimdTest : public LabTest, public ::testing::WithParamInterface<NaiveSimdSimulation::Kernel> {
+protected:
+    static double universe_extent(Universe& uni){
+        BoundingBox bb = uni.get_bounding_box();
+        return std::max(bb.x_max - bb.x_min, bb.y_max - bb.y_min);
+    }
+};
+
+TEST_P(NaiveSimdTest, test_forces_match_sequential){
+    if(!NaiveSimdSimulation::is_supported(GetParam())){
+        GTEST_SKIP() << "kernel not supported by this CPU";
+    }
+
+    // odd count, so the last tile and the source columns are padded
+    Universe uni = create_seeded_universe(1001);
+
+    Universe reference = uni;
+    NaiveSequentialSimulation::calculate_forces(reference);
+    NaiveSimdSimulation::calculate_forces(uni, GetParam());
+
+    // The kernels shift and scale the positions into the unit square, which
+    // rounds every separation by about machine epsilon times the extent, so
+    // close pairs carry a relative error of extent / r_ij.
+    const double length = universe_extent(uni);
+    const double tolerance = 64.0 * std::numeric_limits<double>::epsilon();
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        double scale = pair_force_scale(uni, i, length);
+        ASSERT_NEAR(uni.forces[i].x, reference.forces[i].x, scale * tolerance);
+        ASSERT_NEAR(uni.forces[i].y, reference.forces[i].y, scale * tolerance);
+    }
+}
+
+TEST_P(NaiveSimdTest, test_forces_match_scalar_kernel){
+    if(!NaiveSimdSimulation::is_supported(GetParam())){
+        GTEST_SKIP() << "kernel not supported by this CPU";
+    }
+
+    // the vector kernels see the same scaled columns as the scalar kernel and
+    // only differ in the rsqrt estimate and the summation order
+    Universe uni = create_seeded_universe(1001);
+
+    Universe reference = uni;
+    NaiveSimdSimulation::calculate_forces(reference, NaiveSimdSimulation::Kernel::scalar);
+    NaiveSimdSimulation::calculate_forces(uni, GetParam());
+
+    const double tolerance = 64.0 * std::numeric_limits<double>::epsilon();
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        double scale = pair_force_scale(uni, i);
+        ASSERT_NEAR(uni.forces[i].x, reference.forces[i].x, scale * tolerance);
+        ASSERT_NEAR(uni.forces[i].y, reference.forces[i].y, scale * tolerance);
+    }
+}
+
+TEST_F(NaiveSimdTest, test_detect_kernel){
+    ASSERT_TRUE(NaiveSimdSimulation::is_supported(NaiveSimdSimulation::detect_kernel()));
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, NaiveSimdTest, ::testing::Values(NaiveSimdSimulation::Kernel::scalar, NaiveSimdSimulation::Kernel::avx2, NaiveSimdSimulation::Kernel::avx512));
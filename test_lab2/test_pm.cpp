@@ -0,0 +1,51 @@
+#include "test.h"
+
+#include <cmath>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "simulation/pm_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class PmTest : public LabTest {};
+
+TEST_F(PmTest, test_two_bodies){
+    // two bodies many cells apart attract each other like point masses
+    Universe uni;
+    uni.positions = {{0.0, 0.0}, {1.0e12, 0.0}};
+    uni.weights = {1.0e30, 2.0e30};
+    uni.velocities = {{0.0, 0.0}, {0.0, 0.0}};
+    uni.forces = {{0.0, 0.0}, {0.0, 0.0}};
+    uni.num_bodies = 2;
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+    PmSimulation::calculate_forces(uni, 64);
+
+    ASSERT_LT(relative_force_error(uni, reference), 1e-6);
+    // action and reaction
+    ASSERT_NEAR(uni.forces[0].x, -uni.forces[1].x, std::abs(uni.forces[0].x) * 1e-9);
+}
+
+TEST_F(PmTest, test_error_decreases_with_grid_size){
+    Universe uni;
+    InputGenerator::create_random_universe(2000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    double previous_error = 1.0;
+    for(std::int32_t grid_size : {64, 256, 1024}){
+        PmSimulation::calculate_forces(uni, grid_size);
+        double error = relative_force_error(uni, reference);
+        ASSERT_LT(error, previous_error);
+        previous_error = error;
+    }
+}
+
+TEST_F(PmTest, test_invalid_grid_size){
+    Universe uni;
+    InputGenerator::create_random_universe(10, uni);
+    ASSERT_THROW(PmSimulation::calculate_forces(uni, 100), std::invalid_argument);
+}
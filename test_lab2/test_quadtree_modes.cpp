@@ -0,0 +1,246 @@
+#include "test.h"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "quadtree/quadtree.h"
+
+class QuadtreeModeTest : public LabTest, public ::testing::WithParamInterface<std::int8_t> {};
+
+TEST_P(QuadtreeModeTest, test_structure){
+    Universe uni;
+    InputGenerator::create_random_universe(5000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), GetParam());
+    ASSERT_TRUE(qt.root != nullptr);
+
+    std::vector<QuadtreeNode*> queue = {qt.root};
+    std::set<std::int32_t> bodies;
+    while(queue.size() > 0){
+        auto current = queue.back();
+        queue.pop_back();
+        ASSERT_TRUE(current->children.size() <= 4);
+
+        if(current->children.size() == 0){
+            ASSERT_FALSE(current->bodies.empty());
+            ASSERT_EQ(current->body_identifier, current->bodies[0]);
+            for(auto body: current->bodies){
+                ASSERT_TRUE(current->bounding_box.contains(uni.positions[body]));
+                bodies.insert(body);
+            }
+        }
+        else{
+            ASSERT_EQ(current->body_identifier, -1);
+            for(auto child: current->children){
+                ASSERT_TRUE(current->bounding_box.contains(Vector2d<double>(child->bounding_box.x_min, child->bounding_box.y_min)));
+                ASSERT_TRUE(current->bounding_box.contains(Vector2d<double>(child->bounding_box.x_max, child->bounding_box.y_max)));
+                queue.push_back(child);
+            }
+        }
+    }
+    // every body is stored in exactly one leaf
+    ASSERT_EQ(bodies.size(), uni.num_bodies);
+}
+
+TEST_P(QuadtreeModeTest, test_center_of_mass){
+    Universe uni;
+    InputGenerator::create_random_universe(5000, uni);
+
+    double total_mass = 0.0;
+    Vector2d<double> weighted_position(0.0, 0.0);
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        total_mass += uni.weights[i];
+        weighted_position += uni.positions[i] * uni.weights[i];
+    }
+    Vector2d<double> center_of_mass = weighted_position / total_mass;
+
+    // the moments are computed while the tree is built
+    Quadtree qt(uni, uni.get_bounding_box(), GetParam());
+    ASSERT_TRUE(qt.root->cumulative_mass_ready);
+    ASSERT_TRUE(qt.root->center_of_mass_ready);
+
+    ASSERT_NEAR(qt.root->cumulative_mass, total_mass, total_mass * 1e-12);
+    ASSERT_NEAR(qt.root->center_of_mass.x, center_of_mass.x, std::abs(center_of_mass.x) * 1e-9);
+    ASSERT_NEAR(qt.root->center_of_mass.y, center_of_mass.y, std::abs(center_of_mass.y) * 1e-9);
+}
+
+TEST_P(QuadtreeModeTest, test_skewed_universe){
+    // clustered bodies give subtrees of very different sizes
+    Universe uni;
+    InputGenerator::create_random_universe_with_supermassive_blackholes(20000, uni, 4);
+    Quadtree qt(uni, uni.get_bounding_box(), GetParam());
+
+    std::vector<QuadtreeNode*> queue = {qt.root};
+    std::size_t bodies = 0;
+    while(queue.size() > 0){
+        auto current = queue.back();
+        queue.pop_back();
+        bodies += current->bodies.size();
+        for(auto child: current->children){
+            queue.push_back(child);
+        }
+    }
+    ASSERT_EQ(bodies, uni.num_bodies);
+}
+
+INSTANTIATE_TEST_SUITE_P(ConstructModes, QuadtreeModeTest, ::testing::Values(0, 1, 2, 3));
+
+class NodeArenaTest : public LabTest {};
+
+TEST_F(NodeArenaTest, test_reuse){
+    Universe uni;
+    InputGenerator::create_random_universe(20000, uni);
+    QuadtreeNodeArena arena;
+
+    std::size_t reserved_chunks = 0;
+    {
+        Quadtree qt(uni, uni.get_bounding_box(), 0, arena);
+        reserved_chunks = arena.reserved_chunks();
+        ASSERT_GT(reserved_chunks, 0);
+    }
+    // a second tree of the same size fits into the chunks of the first one
+    {
+        Quadtree qt(uni, uni.get_bounding_box(), 0, arena);
+        qt.calculate_cumulative_masses();
+        ASSERT_EQ(arena.reserved_chunks(), reserved_chunks);
+    }
+}
+
+TEST_F(NodeArenaTest, test_one_live_tree_per_arena){
+    Universe uni;
+    InputGenerator::create_random_universe(1000, uni);
+    QuadtreeNodeArena arena;
+
+    Quadtree qt(uni, uni.get_bounding_box(), 2, arena);
+    // a second tree would reset the nodes of the first one when destroyed
+    ASSERT_THROW(Quadtree(uni, uni.get_bounding_box(), 2, arena), std::logic_error);
+    // the first tree still holds the arena and its nodes
+    ASSERT_EQ(qt.root->children.size(), 4);
+}
+
+TEST_F(NodeArenaTest, test_epoch_arena_per_thread){
+    Universe uni;
+    InputGenerator::create_random_universe(1000, uni);
+    QuadtreeNodeArena& arena = QuadtreeNodeArena::epoch_arena();
+    ASSERT_EQ(&QuadtreeNodeArena::epoch_arena(), &arena);
+
+    // a tree built on another thread does not collide with the tree of this one
+    Quadtree qt(uni, uni.get_bounding_box(), 2, arena);
+    bool distinct = false;
+    std::thread other([&]{
+        QuadtreeNodeArena& other_arena = QuadtreeNodeArena::epoch_arena();
+        distinct = &other_arena != &arena;
+        Quadtree other_qt(uni, uni.get_bounding_box(), 2, other_arena);
+    });
+    other.join();
+    ASSERT_TRUE(distinct);
+}
+
+class QuadtreeUpdateTest : public LabTest {
+protected:
+    // moves every body by up to max_step times the extent of the universe
+    static void jitter(Universe& uni, double max_step){
+        BoundingBox bb = uni.get_bounding_box();
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> step(-max_step, max_step);
+        for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+            uni.positions[i] += Vector2d<double>(step(generator) * (bb.x_max - bb.x_min), step(generator) * (bb.y_max - bb.y_min));
+        }
+    }
+
+    // every body sits in exactly one leaf whose box contains it, moments match the bodies
+    static void check_tree(Universe& uni, Quadtree& qt){
+        std::vector<QuadtreeNode*> queue = {qt.root};
+        std::vector<std::int32_t> seen(uni.num_bodies, 0);
+        while(queue.size() > 0){
+            auto current = queue.back();
+            queue.pop_back();
+            for(auto body: current->bodies){
+                ASSERT_TRUE(current->bounding_box.contains(uni.positions[body]));
+                seen[body]++;
+            }
+            for(auto child: current->children){
+                queue.push_back(child);
+            }
+        }
+        for(auto count: seen){
+            ASSERT_EQ(count, 1);
+        }
+
+        double total_mass = 0.0;
+        Vector2d<double> weighted_position(0.0, 0.0);
+        for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+            total_mass += uni.weights[i];
+            weighted_position += uni.positions[i] * uni.weights[i];
+        }
+        Vector2d<double> center_of_mass = weighted_position / total_mass;
+        ASSERT_NEAR(qt.root->cumulative_mass, total_mass, total_mass * 1e-12);
+        ASSERT_NEAR(qt.root->center_of_mass.x, center_of_mass.x, std::abs(center_of_mass.x) * 1e-9);
+        ASSERT_NEAR(qt.root->center_of_mass.y, center_of_mass.y, std::abs(center_of_mass.y) * 1e-9);
+    }
+};
+
+TEST_F(QuadtreeUpdateTest, test_refit){
+    Universe uni;
+    InputGenerator::create_random_universe(5000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+
+    // small steps, some bodies change their leaf, both rebuild limits are off
+    for(int epoch = 0; epoch < 3; epoch++){
+        jitter(uni, 1e-3);
+        ASSERT_FALSE(qt.update(uni, 1.0, 0.0));
+        check_tree(uni, qt);
+    }
+    ASSERT_GT(qt.migrated_bodies, 0);
+}
+
+TEST_F(QuadtreeUpdateTest, test_grow_root){
+    Universe uni;
+    InputGenerator::create_random_universe(1000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), 0);
+
+    BoundingBox bb = uni.get_bounding_box();
+    uni.positions[0] = Vector2d<double>(bb.x_max + (bb.x_max - bb.x_min), bb.y_min - (bb.y_max - bb.y_min) / 2);
+    ASSERT_FALSE(qt.update(uni, 1.0));
+    check_tree(uni, qt);
+}
+
+TEST_F(QuadtreeUpdateTest, test_rebuild){
+    Universe uni;
+    InputGenerator::create_random_universe(5000, uni);
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+
+    // large steps move most bodies out of their leaves
+    jitter(uni, 0.1);
+    ASSERT_TRUE(qt.update(uni, 0.1));
+    ASSERT_EQ(qt.migrated_bodies, 0);
+    check_tree(uni, qt);
+}
+
+TEST_F(QuadtreeUpdateTest, test_rebuild_on_low_occupancy){
+    Universe uni = create_seeded_universe(5000);
+    Quadtree qt(uni, uni.get_bounding_box(), 2);
+    Universe unchecked_uni = uni;
+    Quadtree unchecked_qt(unchecked_uni, unchecked_uni.get_bounding_box(), 2);
+
+    // every fifth body jumps to a random spot, the reinsertions split leaves
+    BoundingBox bb = uni.get_bounding_box();
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> x(bb.x_min, bb.x_max);
+    std::uniform_real_distribution<double> y(bb.y_min, bb.y_max);
+    for(std::uint32_t i = 0; i < uni.num_bodies; i += 5){
+        uni.positions[i] = Vector2d<double>(x(generator), y(generator));
+        unchecked_uni.positions[i] = uni.positions[i];
+    }
+
+    // the migration limit is off, only the occupancy triggers the rebuild
+    ASSERT_FALSE(unchecked_qt.update(unchecked_uni, 1.0, 0.0));
+    ASSERT_TRUE(qt.update(uni, 1.0));
+    ASSERT_EQ(qt.migrated_bodies, 0);
+    check_tree(uni, qt);
+}
@@ -0,0 +1,92 @@
+#include "test.h"
+
+#include <exception>
+#include <iostream>
+
+#include "structures/universe.h"
+#include "structures/universe_soa.h"
+#include "utilities/import.hpp"
+#include "simulation/naive_parallel_simulation.h"
+
+#include "utilities.h"
+
+
+class SoATest : public LabTest {};
+
+TEST_F(SoATest, test_round_trip){
+    Universe uni;
+    auto tmp = std::filesystem::path{"../test_input_grading/test_five_ppws24_D75C_universe_after_calculate_forces.txt"};
+    load_universe(tmp, uni);
+
+    UniverseSoA soa(uni);
+    ASSERT_EQ(soa.num_bodies, uni.num_bodies);
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        // columns are cache line aligned
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(soa.pos_x.data()) % 64, 0);
+        ASSERT_EQ(soa.positions()[i], uni.positions[i]);
+        ASSERT_EQ(soa.velocities()[i], uni.velocities[i]);
+        ASSERT_EQ(soa.forces()[i], uni.forces[i]);
+        ASSERT_EQ(soa.weights[i], uni.weights[i]);
+    }
+
+    Universe copy;
+    soa.store_to(copy);
+    ASSERT_EQ(copy.num_bodies, uni.num_bodies);
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        ASSERT_EQ(copy.positions[i], uni.positions[i]);
+        ASSERT_EQ(copy.velocities[i], uni.velocities[i]);
+    }
+}
+
+TEST_F(SoATest, test_kernels_match_reference){
+    Universe uni;
+    auto tmp = std::filesystem::path{"../test_input_grading/test_five_ppws24_D75C_universe.txt"};
+    load_universe(tmp, uni);
+
+    Universe reference_uni;
+    load_universe(tmp, reference_uni);
+    NaiveParallelSimulation::calculate_forces(reference_uni);
+    NaiveParallelSimulation::calculate_velocities(reference_uni);
+    NaiveParallelSimulation::calculate_positions(reference_uni);
+
+    UniverseSoA soa(uni);
+    NaiveParallelSimulation::calculate_forces(soa);
+    NaiveParallelSimulation::calculate_velocities(soa);
+    NaiveParallelSimulation::calculate_positions(soa);
+    soa.store_to(uni);
+
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        ASSERT_NEAR(uni.forces[i][0], reference_uni.forces[i][0], std::abs(reference_uni.forces[i][0]) * 1e-9);
+        ASSERT_NEAR(uni.forces[i][1], reference_uni.forces[i][1], std::abs(reference_uni.forces[i][1]) * 1e-9);
+        ASSERT_NEAR(uni.velocities[i][0], reference_uni.velocities[i][0], std::abs(reference_uni.velocities[i][0]) * 1e-9);
+        ASSERT_NEAR(uni.velocities[i][1], reference_uni.velocities[i][1], std::abs(reference_uni.velocities[i][1]) * 1e-9);
+        ASSERT_NEAR(uni.positions[i][0], reference_uni.positions[i][0], std::abs(reference_uni.positions[i][0]) * 1e-9);
+        ASSERT_NEAR(uni.positions[i][1], reference_uni.positions[i][1], std::abs(reference_uni.positions[i][1]) * 1e-9);
+    }
+}
+
+template <typename Precision> double max_relative_force_error(Universe& uni){
+    UniverseSoA reference(uni);
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    BasicUniverseSoA<Precision> soa(uni);
+    NaiveParallelSimulation::calculate_forces(soa);
+
+    double max_error = 0.0;
+    for(std::uint32_t i = 0; i < uni.num_bodies; i++){
+        Vector2d<double> reference_force = reference.forces()[i];
+        Vector2d<double> force(soa.force_x[i], soa.force_y[i]);
+        double error = std::sqrt((force - reference_force).norm2() / reference_force.norm2());
+        max_error = std::max(max_error, error);
+    }
+    return max_error;
+}
+
+TEST_F(SoATest, test_reduced_precision){
+    Universe uni;
+    auto tmp = std::filesystem::path{"../test_input_grading/test_five_ppws24_D75C_universe.txt"};
+    load_universe(tmp, uni);
+
+    ASSERT_LT(max_relative_force_error<FloatPrecision>(uni), 1e-3);
+    ASSERT_LT(max_relative_force_error<FloatComputePrecision>(uni), 1e-4);
+}
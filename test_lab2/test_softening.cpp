@@ -0,0 +1,82 @@
+#include "test.h"
+
+#include <cmath>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+#include "physics/gravitation.h"
+
+#include "quadtree/quadtree.h"
+
+#include "simulation/naive_sequential_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+#include "simulation/naive_simd_simulation.h"
+#include "simulation/barnes_hut_simulation.h"
+#include "simulation/fmm_simulation.h"
+
+// sets the global softening length for one test and restores it afterwards
+class SofteningTest : public LabTest {
+protected:
+    void TearDown() override {
+        softening_length = 0.0;
+    }
+};
+
+TEST_F(SofteningTest, test_gravitational_force){
+    // without softening exactly the plain inverse square law
+    ASSERT_DOUBLE_EQ(gravitational_force(2.0, 3.0, 4.0), gravitational_constant * 6.0 / 16.0);
+    ASSERT_EQ(gravitational_force(2.0, 3.0, 0.0), 0.0);
+    const double m1 = 51675124.92141;
+    const double m2 = 6156212332.2151;
+    const double d = 41512561251512455.2211;
+    ASSERT_EQ(gravitational_force(m1, m2, d), gravitational_constant * ((m1 * m2) / (d * d)));
+
+    // F = G m1 m2 r / (r^2 + eps^2)^(3/2)
+    softening_length = 3.0;
+    ASSERT_DOUBLE_EQ(gravitational_force(2.0, 3.0, 4.0), gravitational_constant * 6.0 * 4.0 / 125.0);
+    ASSERT_EQ(gravitational_force(2.0, 3.0, 0.0), 0.0);
+}
+
+TEST_F(SofteningTest, test_engines_agree){
+    Universe uni;
+    InputGenerator::create_random_universe(1000, uni);
+    BoundingBox bb = uni.get_bounding_box();
+    // a softening length of a typical body distance changes the forces noticeably
+    softening_length = (bb.x_max - bb.x_min) / std::sqrt(static_cast<double>(uni.num_bodies));
+    // two coincident bodies
+    uni.positions[1] = uni.positions[0];
+
+    Universe reference = uni;
+    NaiveSequentialSimulation::calculate_forces(reference);
+
+    // a non-finite force makes the error non-finite, which fails the upper bounds
+    Universe parallel = uni;
+    NaiveParallelSimulation::calculate_forces(parallel);
+    ASSERT_LT(relative_force_error(parallel, reference), 1e-12);
+
+    Universe simd = uni;
+    NaiveSimdSimulation::calculate_forces(simd);
+    ASSERT_LT(relative_force_error(simd, reference), 1e-12);
+
+    Universe soa_universe = uni;
+    UniverseSoA soa(soa_universe);
+    NaiveParallelSimulation::calculate_forces(soa);
+    soa.store_to(soa_universe);
+    ASSERT_LT(relative_force_error(soa_universe, reference), 1e-12);
+
+    Universe barnes_hut = uni;
+    Quadtree qt(barnes_hut, barnes_hut.get_bounding_box(), 2);
+    BarnesHutSimulation::calculate_forces(barnes_hut, qt);
+    ASSERT_LT(relative_force_error(barnes_hut, reference), 1e-2);
+
+    Universe fmm = uni;
+    Quadtree fmm_qt(fmm, fmm.get_bounding_box(), 2, FmmSimulation::default_leaf_capacity);
+    FmmSimulation::calculate_forces(fmm, fmm_qt);
+    ASSERT_LT(relative_force_error(fmm, reference), 1e-2);
+
+    // the unsoftened forces differ
+    softening_length = 0.0;
+    Universe unsoftened = uni;
+    NaiveParallelSimulation::calculate_forces(unsoftened);
+    ASSERT_GT(relative_force_error(unsoftened, reference), 1e-2);
+}
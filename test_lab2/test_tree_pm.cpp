@@ -0,0 +1,53 @@
+#include "test.h"
+
+#include <cmath>
+
+#include "structures/universe.h"
+#include "input_generator/input_generator.h"
+
+#include "simulation/tree_pm_simulation.h"
+#include "simulation/pm_simulation.h"
+#include "simulation/naive_parallel_simulation.h"
+
+class TreePmTest : public LabTest {};
+
+TEST_F(TreePmTest, test_close_pair){
+    // the pair sits within one cell, the mesh alone cannot resolve it
+    Universe uni;
+    uni.positions = {{0.0, 0.0}, {1.0e9, 0.0}, {6.4e11, 6.4e11}};
+    uni.weights = {1.0e30, 2.0e30, 1.0e20};
+    uni.velocities = {{0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}};
+    uni.forces = {{0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}};
+    uni.num_bodies = 3;
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+    Universe pm = uni;
+    PmSimulation::calculate_forces(pm, 64);
+    Quadtree quadtree(uni, uni.get_bounding_box(), 2, TreePmSimulation::default_leaf_capacity);
+    TreePmSimulation::calculate_forces(uni, quadtree, 64);
+
+    ASSERT_GT(std::abs(pm.forces[0].x - reference.forces[0].x), 0.5 * std::abs(reference.forces[0].x));
+    ASSERT_NEAR(uni.forces[0].x, reference.forces[0].x, std::abs(reference.forces[0].x) * 1e-3);
+    ASSERT_NEAR(uni.forces[1].x, reference.forces[1].x, std::abs(reference.forces[1].x) * 1e-3);
+}
+
+TEST_F(TreePmTest, test_more_accurate_than_pm){
+    Universe uni;
+    InputGenerator::create_random_universe(3000, uni);
+
+    Universe reference = uni;
+    NaiveParallelSimulation::calculate_forces(reference);
+
+    for(std::int32_t grid_size : {64, 256}){
+        Universe pm = uni;
+        PmSimulation::calculate_forces(pm, grid_size);
+        Quadtree quadtree(uni, uni.get_bounding_box(), 2, TreePmSimulation::default_leaf_capacity);
+        TreePmSimulation::calculate_forces(uni, quadtree, grid_size);
+
+        double pm_error = relative_force_error(pm, reference);
+        double tree_pm_error = relative_force_error(uni, reference);
+        ASSERT_LT(tree_pm_error, 0.5 * pm_error);
+        ASSERT_LT(tree_pm_error, 0.02);
+    }
+}